@@ -0,0 +1,60 @@
+#include "arena.hpp"
+
+const size_t Arena::block_size = 64 * 1024;
+
+Arena::~Arena()
+{
+        while (first) {
+                Block *tmp = first;
+                first = first->next;
+                delete[] (char *)tmp;
+        }
+}
+
+void *Arena::Alloc(size_t size)
+{
+        size = (size + sizeof(long) - 1) & ~(sizeof(long) - 1);
+        if (size > size_t(limit - top))
+                Grow(size);
+        void *res = top;
+        top += size;
+        return res;
+}
+
+void Arena::Rewind()
+{
+        Block **link = &first;
+        while (*link) {
+                Block *tmp = *link;
+                if (tmp == first && tmp->size == block_size) {
+                        link = &tmp->next;
+                        continue;
+                }
+                *link = tmp->next;
+                delete[] (char *)tmp;
+        }
+        current = first;
+        top = first ? Data(first) : 0;
+        limit = first ? top + first->size : 0;
+}
+
+void Arena::Grow(size_t size)
+{
+        Block *next = current ? current->next : first;
+        if (!next || next->size < size) {
+                size_t len = size > block_size ? size : block_size;
+                next = (Block *)new char[sizeof(Block) + len];
+                next->size = len;
+                if (current) {
+                        next->next = current->next;
+                        current->next = next;
+                } else {
+                        next->next = first;
+                        first = next;
+                }
+        }
+        current = next;
+        top = Data(current);
+        limit = top + current->size;
+}
+
@@ -0,0 +1,31 @@
+#ifndef ARENA_HPP_SENTRY
+#define ARENA_HPP_SENTRY
+
+#include <cstddef>
+
+class Arena {
+        struct Block {
+                Block *next;
+                size_t size;
+        };
+        Block *first;
+        Block *current;
+        char *top;
+        char *limit;
+        static const size_t block_size;
+public:
+        Arena() : first(0), current(0), top(0), limit(0) {}
+        ~Arena();
+        void *Alloc(size_t size);
+        void Reset() { if (current != first || top != Start()) Rewind(); }
+private:
+        Arena(const Arena&);
+        void operator=(const Arena&);
+        void Rewind();
+        void Grow(size_t size);
+        char *Start() const { return first ? Data(first) : 0; }
+        static char *Data(Block *block) { return (char *)(block + 1); }
+};
+
+#endif
+
@@ -1,113 +1,553 @@
+#include <cstring>
 #include "array.hpp"
-#include "engine.hpp"
 #include "error.hpp"
 #include "common.hpp"
 
-Variable::Variable()
+const unsigned long Array::max_size = (~0UL >> 1) / sizeof(Value);
+
+Array::Array(unsigned long size)
 {
-        type = int_type;
-        value.integer = 0;
+        Create(long_kind, size);
 }
 
-Variable::Variable(const Variable& var)
+Array::~Array()
 {
-        type = var.type;
-        if (var.type == string_type)
-                value.string = dupstr(var.value.string);
-        else
-                value = var.value;
+        try {
+                Release();
+        } catch (const Error& err) {
+                err.Report();
+        }
 }
 
-Variable::~Variable()
+void Array::Allocate(unsigned long size)
 {
-        if (type == string_type)
-                delete []value.string;
+        if (size == 0 || size > max_size)
+                throw RuntimeError("bad allocation", "Array");
+        if (Empty()) {
+                Release();
+                Create(size >= sparse_min ? sparse_kind : long_kind, size);
+                return;
+        }
+        if (!file) {
+                if (kind != sparse_kind && size >= sparse_min &&
+                    size / 4 > allocated)
+                        Sparsify();
+                else if (kind != long_kind && kind != value_kind &&
+                         size > allocated)
+                        Promote();
+        }
+        Resize(size);
+}
+
+void Array::Map(const char *name, DataType type, unsigned long size)
+{
+        Kind k = KindOf(type);
+        if (k == value_kind)
+                throw RuntimeError("RPNValue", "data type mismatch");
+        if (size > max_size)
+                throw RuntimeError("bad allocation", "Array");
+        Clear();
+        MappedFile *tmp = new MappedFile(name);
+        if (tmp->Type() == -1 && tmp->Count() == 0)
+                tmp->SetType(k);
+        if (tmp->Count() > max_size || Bytes(k, tmp->Count()) > tmp->Size()) {
+                delete tmp;
+                throw RuntimeError(name, "bad file format");
+        }
+        if (tmp->Type() != k) {
+                delete tmp;
+                throw RuntimeError("RPNValue", "data type mismatch");
+        }
+        if (size == 0 && tmp->Count() == 0) {
+                delete tmp;
+                throw RuntimeError("bad allocation", "Array");
+        }
+        Array arr;
+        arr.file = tmp;
+        arr.kind = k;
+        arr.allocated = tmp->Count();
+        arr.Remap(arr.allocated);
+        arr.Resize(size ? size : arr.allocated);
+        Swap(arr);
 }
 
-Variable& Variable::operator=(const Variable& var)
+void Array::Append(const Value& val)
 {
-        type = var.type;
-        if (var.type == string_type)
-                value.string = dupstr(var.value.string);
+        if (Empty())
+                Allocate(1);
         else
-                value = var.value;
-        return *this;
+                Resize(allocated + 1);
+        Set(allocated - 1, val);
 }
 
-void Variable::Set(RPNValue *val)
+void Array::Clear()
 {
-        if (type == string_type)
-                delete []value.string;
-        switch (val->Type()) {
-        case bool_type:
-                type = bool_type;
-                value.boolean = val->GetBool();
+        Release();
+        data.longs = 0;
+        allocated = 0;
+        capacity = 0;
+        kind = long_kind;
+}
+
+void Array::Swap(Array& arr)
+{
+        Value *tmp_data = data.values;
+        unsigned long tmp_allocated = allocated;
+        unsigned long tmp_capacity = capacity;
+        unsigned long tmp_live = live;
+        Kind tmp_kind = kind;
+        long *tmp_refs = refs;
+        MappedFile *tmp_file = file;
+        data.values = arr.data.values;
+        allocated = arr.allocated;
+        capacity = arr.capacity;
+        live = arr.live;
+        kind = arr.kind;
+        refs = arr.refs;
+        file = arr.file;
+        arr.data.values = tmp_data;
+        arr.allocated = tmp_allocated;
+        arr.capacity = tmp_capacity;
+        arr.live = tmp_live;
+        arr.kind = tmp_kind;
+        arr.refs = tmp_refs;
+        arr.file = tmp_file;
+}
+
+void Array::Share(Array& arr)
+{
+        if (this == &arr || (refs && refs == arr.refs))
+                return;
+        if (arr.Empty()) {
+                Clear();
+                return;
+        }
+        if (arr.file) {
+                Array tmp;
+                tmp.Create(arr.kind, arr.allocated);
+                memcpy(tmp.data.bits, arr.data.bits,
+                       Bytes(arr.kind, arr.allocated));
+                Swap(tmp);
+                return;
+        }
+        Release();
+        if (!arr.refs)
+                arr.refs = new long(1);
+        (*arr.refs)++;
+        data.values = arr.data.values;
+        allocated = arr.allocated;
+        capacity = arr.capacity;
+        live = arr.live;
+        kind = arr.kind;
+        refs = arr.refs;
+        file = arr.file;
+}
+
+void Array::Get(unsigned long index, Value& val) const
+{
+        Check(index);
+        switch (kind) {
+        case long_kind:
+                val.Set(data.longs[index]);
                 break;
-        case int_type:
-                type = int_type;
-                value.integer = val->GetInt();
+        case double_kind:
+                val.Set(data.doubles[index]);
                 break;
-        case double_type:
-                type = double_type;
-                value.real = val->GetDouble();
+        case bool_kind:
+                val.Set(bool(data.bits[index >> 3] >> (index & 7) & 1));
+                break;
+        case value_kind:
+                val = data.values[index];
+                break;
+        case sparse_kind:
+                if (data.pages[index >> page_bits])
+                        data.pages[index >> page_bits]->Get(index & page_mask,
+                                                            val);
+                else
+                        val.Set(0L);
                 break;
-        case string_type:
-                type = string_type;
-                value.string = dupstr(val->GetString());
         }
 }
 
-RPNValue *Variable::Get() const
+void Array::Set(unsigned long index, const Value& val)
 {
-        switch (type) {
-        case bool_type:
-                return new RPNValue(value.boolean);
-        case int_type:
-                return new RPNValue(value.integer);
-        case double_type:
-                return new RPNValue(value.real);
-        case string_type:
-                return new RPNValue(value.string);
+        Check(index);
+        Unshare();
+        if (kind == sparse_kind) {
+                if (!data.pages[index >> page_bits] && Zero(val))
+                        return;
+                Array *page = Page(index);
+                Value old;
+                page->Get(index & page_mask, old);
+                page->Set(index & page_mask, val);
+                Count(old, val);
+                return;
+        }
+        Kind k = KindOf(val.Type());
+        if (k != kind && file) {
+                if (kind != double_kind || k != long_kind)
+                        throw RuntimeError("RPNValue", "data type mismatch");
+                data.doubles[index] = val.Int();
+                return;
+        }
+        if (k != kind && allocated == 1) {
+                Release();
+                Create(k, 1);
+        } else if (k != kind) {
+                Promote();
+        }
+        switch (kind) {
+        case long_kind:
+                data.longs[index] = val.Int();
+                break;
+        case double_kind:
+                data.doubles[index] = val.Double();
+                break;
+        case bool_kind:
+                if (val.Bool())
+                        data.bits[index >> 3] |= 1 << (index & 7);
+                else
+                        data.bits[index >> 3] &= ~(1 << (index & 7));
+                break;
+        case value_kind:
+                data.values[index] = val;
+                break;
+        case sparse_kind:
+                break;
         }
-        return 0;
 }
 
-Array::Array(unsigned long size)
+void Array::Step(unsigned long index, long delta)
+{
+        Check(index);
+        Unshare();
+        if (kind == sparse_kind) {
+                Array *page = Page(index);
+                Value old, val;
+                page->Get(index & page_mask, old);
+                page->Step(index & page_mask, delta);
+                page->Get(index & page_mask, val);
+                Count(old, val);
+                return;
+        }
+        if (kind == long_kind) {
+                data.longs[index] += delta;
+        } else if (kind == value_kind) {
+                Value& var = data.values[index];
+                var.SetInt(var.GetInt() + delta);
+        } else {
+                throw RuntimeError("RPNValue", "data type mismatch");
+        }
+}
+
+Value *Array::Ref(unsigned long index)
 {
-        var = new Variable[size];
+        Check(index);
+        Unshare();
+        return kind == value_kind ? data.values + index : 0;
+}
+
+void Array::Create(Kind k, unsigned long size)
+{
+        refs = 0;
+        file = 0;
+        kind = k;
         allocated = size;
+        capacity = size;
+        live = 0;
+        switch (kind) {
+        case long_kind:
+                data.longs = new long[size];
+                break;
+        case double_kind:
+                data.doubles = new double[size];
+                break;
+        case bool_kind:
+                data.bits = new unsigned char[(size + 7) / 8];
+                memset(data.bits, 0, (size + 7) / 8);
+                break;
+        case value_kind:
+                data.values = new Value[size];
+                break;
+        case sparse_kind:
+                capacity = (size + page_mask) & ~(unsigned long)page_mask;
+                data.pages = new Array*[capacity >> page_bits];
+                memset(data.pages, 0, (capacity >> page_bits) * sizeof(Array*));
+                return;
+        }
+        Fill(0, size);
 }
 
-Array::Array(const Array& arr)
+void Array::Resize(unsigned long size)
 {
-        var = new Variable[arr.allocated];
-        allocated = arr.allocated;
+        Unshare();
+        if (size > capacity && file)
+                Remap(size > 2 * capacity ? size : 2 * capacity);
+        if (size <= capacity) {
+                if (size < allocated)
+                        Fill(size, allocated);
+                allocated = size;
+                if (file)
+                        file->SetCount(size);
+                return;
+        }
+        Array tmp;
+        tmp.Create(kind, size > 2 * capacity ? size : 2 * capacity);
+        switch (kind) {
+        case long_kind:
+                memcpy(tmp.data.longs, data.longs, allocated * sizeof(long));
+                break;
+        case double_kind:
+                memcpy(tmp.data.doubles, data.doubles,
+                       allocated * sizeof(double));
+                break;
+        case bool_kind:
+                memcpy(tmp.data.bits, data.bits, (allocated + 7) / 8);
+                break;
+        case value_kind:
+                for (unsigned long i = 0; i < allocated; i++)
+                        tmp.data.values[i].Swap(data.values[i]);
+                break;
+        case sparse_kind:
+                memcpy(tmp.data.pages, data.pages,
+                       (capacity >> page_bits) * sizeof(Array*));
+                memset(data.pages, 0, (capacity >> page_bits) * sizeof(Array*));
+                tmp.live = live;
+                break;
+        }
+        tmp.allocated = size;
+        Swap(tmp);
+}
+
+void Array::Fill(unsigned long from, unsigned long to)
+{
+        switch (kind) {
+        case long_kind:
+                memset(data.longs + from, 0, (to - from) * sizeof(long));
+                break;
+        case double_kind:
+                memset(data.doubles + from, 0, (to - from) * sizeof(double));
+                break;
+        case bool_kind:
+                for (unsigned long i = from; i < to; i++)
+                        data.bits[i >> 3] &= ~(1 << (i & 7));
+                break;
+        case value_kind:
+                for (unsigned long i = from; i < to; i++)
+                        data.values[i].Set(0L);
+                break;
+        case sparse_kind:
+                for (unsigned long i = from; i < to; i = (i | page_mask) + 1) {
+                        Array *&page = data.pages[i >> page_bits];
+                        unsigned long end = (i | page_mask) + 1;
+                        if (!page)
+                                continue;
+                        if (end > to)
+                                end = to;
+                        live -= page->Live(i & page_mask,
+                                           end - (i & ~page_mask));
+                        if (!(i & page_mask) && !(end & page_mask)) {
+                                delete page;
+                                page = 0;
+                                continue;
+                        }
+                        page->Unshare();
+                        page->Fill(i & page_mask, end - (i & ~page_mask));
+                }
+                break;
+        }
+}
+
+void Array::Unshare()
+{
+        if (!refs)
+                return;
+        if (*refs == 1) {
+                delete refs;
+                refs = 0;
+                return;
+        }
+        Array tmp;
+        tmp.Create(kind, capacity);
+        switch (kind) {
+        case long_kind:
+                memcpy(tmp.data.longs, data.longs, allocated * sizeof(long));
+                break;
+        case double_kind:
+                memcpy(tmp.data.doubles, data.doubles,
+                       allocated * sizeof(double));
+                break;
+        case bool_kind:
+                memcpy(tmp.data.bits, data.bits, (allocated + 7) / 8);
+                break;
+        case value_kind:
+                for (unsigned long i = 0; i < allocated; i++)
+                        tmp.data.values[i] = data.values[i];
+                break;
+        case sparse_kind:
+                for (unsigned long i = 0; i < capacity >> page_bits; i++) {
+                        if (!data.pages[i])
+                                continue;
+                        tmp.data.pages[i] = new Array;
+                        tmp.data.pages[i]->Share(*data.pages[i]);
+                }
+                tmp.live = live;
+                break;
+        }
+        tmp.allocated = allocated;
+        (*refs)--;
+        refs = 0;
+        Swap(tmp);
+        tmp.data.values = 0;
+        tmp.file = 0;
+}
+
+void Array::Release()
+{
+        if (refs && --*refs > 0) {
+                refs = 0;
+                file = 0;
+                return;
+        }
+        delete refs;
+        refs = 0;
+        if (file) {
+                bool closed = file->Close(Bytes(kind, allocated));
+                delete file;
+                file = 0;
+                data.bits = 0;
+                allocated = 0;
+                capacity = 0;
+                if (!closed)
+                        throw RuntimeError("cannot truncate file",
+                                           "MappedFile");
+                return;
+        }
+        switch (kind) {
+        case long_kind:
+                delete[] data.longs;
+                break;
+        case double_kind:
+                delete[] data.doubles;
+                break;
+        case bool_kind:
+                delete[] data.bits;
+                break;
+        case value_kind:
+                delete[] data.values;
+                break;
+        case sparse_kind:
+                if (!data.pages)
+                        break;
+                for (unsigned long i = 0; i < capacity >> page_bits; i++)
+                        delete data.pages[i];
+                delete[] data.pages;
+                break;
+        }
+}
+
+void Array::Promote()
+{
+        if (kind == value_kind || kind == sparse_kind)
+                return;
+        Value *tmp = new Value[capacity];
         for (unsigned long i = 0; i < allocated; i++)
-                var[i] = arr.var[i];
+                Get(i, tmp[i]);
+        Release();
+        data.values = tmp;
+        kind = value_kind;
 }
 
-Array::~Array()
+void Array::Sparsify()
 {
-        delete[] var;
+        Array tmp;
+        tmp.Create(sparse_kind, allocated);
+        Value val;
+        for (unsigned long i = 0; i < allocated; i++) {
+                Array *&page = tmp.data.pages[i >> page_bits];
+                if (!page)
+                        page = new Array(page_size);
+                Get(i, val);
+                page->Set(i & page_mask, val);
+        }
+        tmp.live = Live(0, allocated);
+        Swap(tmp);
 }
 
-void Array::Allocate(unsigned long size)
+void Array::Densify()
 {
-        if (size == 0)
-                throw RuntimeError("bad allocation", "Array");
-        unsigned long copy = size < allocated ? size : allocated;
-        allocated = size;
-        Variable *tmp = new Variable[allocated];
-        for (unsigned long i = 0; i < copy; i++)
-                tmp[i] = var[i];
-        delete[] var;
-        var = tmp;
+        Array tmp;
+        tmp.Create(long_kind, allocated);
+        Value val;
+        for (unsigned long i = 0; i < allocated; i++) {
+                const Array *page = data.pages[i >> page_bits];
+                if (!page) {
+                        i |= page_mask;
+                        continue;
+                }
+                page->Get(i & page_mask, val);
+                tmp.Set(i, val);
+        }
+        Swap(tmp);
+}
+
+Array *Array::Page(unsigned long index)
+{
+        Array *&page = data.pages[index >> page_bits];
+        if (!page)
+                page = new Array(page_size);
+        return page;
+}
+
+void Array::Count(const Value& old, const Value& val)
+{
+        if (Zero(old) == Zero(val))
+                return;
+        if (Zero(old))
+                live++;
+        else
+                live--;
+        if (2 * live > allocated)
+                Densify();
+}
+
+unsigned long Array::Live(unsigned long from, unsigned long to) const
+{
+        unsigned long count = 0;
+        Value val;
+        for (unsigned long i = from; i < to; i++) {
+                Get(i, val);
+                if (!Zero(val))
+                        count++;
+        }
+        return count;
+}
+
+void Array::Remap(unsigned long size)
+{
+        file->Resize(Bytes(kind, size));
+        data.bits = (unsigned char *)file->Data();
+        capacity = size;
+}
+
+Array::Kind Array::KindOf(DataType type)
+{
+        switch (type) {
+        case int_type:
+                return long_kind;
+        case double_type:
+                return double_kind;
+        case bool_type:
+                return bool_kind;
+        default:
+                return value_kind;
+        }
 }
 
-Variable& Array::operator[](unsigned long index)
+size_t Array::Bytes(Kind k, unsigned long size)
 {
-        if (index >= allocated)
-                throw RuntimeError("segmentation fault", "Array");
-        return var[index];
+        if (k == bool_kind)
+                return (size + 7) / 8;
+        return size * (k == double_kind ? sizeof(double) : sizeof(long));
 }
 
@@ -1,40 +1,76 @@
 #ifndef ARRAY_HPP_SENTRY
 #define ARRAY_HPP_SENTRY
 
-enum DataType {
-        bool_type,
-        int_type,
-        double_type,
-        string_type
-};
-
-class Variable {
-        friend class Array;
-        DataType type;
-        union {
-                bool boolean;
-                long integer;
-                double real;
-                char *string;
-        } value;
-public:
-        Variable();
-        Variable(const Variable& var);
-        ~Variable();
-        Variable& operator=(const Variable& var);
-        void Set(class RPNValue *val);
-        class RPNValue *Get() const;
-};
+#include "value.hpp"
+#include "mapfile.hpp"
 
 class Array {
-        Variable *var;
+        enum Kind {
+                long_kind,
+                double_kind,
+                bool_kind,
+                value_kind,
+                sparse_kind
+        };
+        enum {
+                page_bits = 10,
+                page_size = 1 << page_bits,
+                page_mask = page_size - 1,
+                sparse_min = 1 << 23
+        };
+        union {
+                long *longs;
+                double *doubles;
+                unsigned char *bits;
+                Value *values;
+                Array **pages;
+        } data;
         unsigned long allocated;
+        unsigned long capacity;
+        unsigned long live;
+        Kind kind;
+        long *refs;
+        MappedFile *file;
+        static const unsigned long max_size;
 public:
+        Array() : allocated(0), capacity(0), live(0), kind(long_kind),
+                refs(0), file(0) { data.longs = 0; }
         Array(unsigned long size);
-        Array(const Array& arr);
         ~Array();
         void Allocate(unsigned long size);
-        Variable& operator[](unsigned long index);
+        void Map(const char *name, DataType type, unsigned long size);
+        void Append(const Value& val);
+        void Clear();
+        void Swap(Array& arr);
+        void Share(Array& arr);
+        bool Empty() const { return allocated == 0; }
+        void Get(unsigned long index, Value& val) const;
+        void Set(unsigned long index, const Value& val);
+        void Step(unsigned long index, long delta);
+        Value *Ref(unsigned long index);
+private:
+        Array(const Array&);
+        void operator=(const Array&);
+        void Check(unsigned long index) const {
+                if (index >= allocated)
+                        throw RuntimeError("segmentation fault", "Array");
+        }
+        void Create(Kind k, unsigned long size);
+        void Resize(unsigned long size);
+        void Fill(unsigned long from, unsigned long to);
+        void Unshare();
+        void Release();
+        void Promote();
+        void Sparsify();
+        void Densify();
+        Array *Page(unsigned long index);
+        void Count(const Value& old, const Value& val);
+        unsigned long Live(unsigned long from, unsigned long to) const;
+        void Remap(unsigned long size);
+        static bool Zero(const Value& val)
+                { return val.Type() == int_type && val.Int() == 0; }
+        static Kind KindOf(DataType type);
+        static size_t Bytes(Kind k, unsigned long size);
 };
 
 #endif
@@ -0,0 +1,99 @@
+#include <cstdio>
+#include <ctime>
+#include "../hashtable.hpp"
+#include "nodetable.hpp"
+
+static const int key_count = 100000;
+static const int lookup_rounds = 10;
+static const int churn_rounds = 20;
+static const int churn_window = 64;
+static const int repeat_rounds = 5;
+
+static char **MakeKeys(int count, const char *prefix)
+{
+        char **keys = new char*[count];
+        char buff[32];
+        for (int i = 0; i < count; i++) {
+                sprintf(buff, "%s%d", prefix, i);
+                keys[i] = dupstr(buff);
+        }
+        return keys;
+}
+
+static double Seconds(clock_t start)
+{
+        return double(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void Keep(double& best, double time)
+{
+        if (best < 0 || time < best)
+                best = time;
+}
+
+template <class Table>
+static long Run(double *best, char **keys, char **misses)
+{
+        long sum = 0;
+        clock_t start = clock();
+        Table *table = new Table;
+        for (int i = 0; i < key_count; i++)
+                table->Add(i, keys[i]);
+        Keep(best[0], Seconds(start));
+        start = clock();
+        for (int r = 0; r < lookup_rounds; r++) {
+                for (int i = 0; i < key_count; i++)
+                        sum += (*table)[keys[i]];
+        }
+        Keep(best[1], Seconds(start));
+        start = clock();
+        for (int r = 0; r < lookup_rounds; r++) {
+                for (int i = 0; i < key_count; i++)
+                        sum += table->Find(misses[i]);
+        }
+        Keep(best[2], Seconds(start));
+        start = clock();
+        for (int r = 0; r < churn_rounds; r++) {
+                for (int i = 0; i < key_count; i++) {
+                        table->Remove(keys[i]);
+                        int j = (i + churn_window) % key_count;
+                        table->Remove(keys[j]);
+                        table->Add(j, keys[j]);
+                        table->Add(i, keys[i]);
+                }
+        }
+        Keep(best[3], Seconds(start));
+        delete table;
+        return sum;
+}
+
+static void Print(const char *name, const double *best, long sum)
+{
+        printf("%-10s %8.3f %8.3f %8.3f %8.3f  (%ld)\n",
+               name, best[0], best[1], best[2], best[3], sum);
+}
+
+int main()
+{
+        char **keys = MakeKeys(key_count, "$var");
+        char **misses = MakeKeys(key_count, "$tmp");
+        printf("%-10s %8s %8s %8s %8s\n",
+               "table", "insert", "hit", "miss", "churn");
+        double node[4] = { -1, -1, -1, -1 };
+        double flat[4] = { -1, -1, -1, -1 };
+        long node_sum = 0, flat_sum = 0;
+        for (int r = 0; r < repeat_rounds; r++) {
+                node_sum = Run<NodeHashTable<long> >(node, keys, misses);
+                flat_sum = Run<HashTable<long> >(flat, keys, misses);
+        }
+        Print("node", node, node_sum);
+        Print("flat", flat, flat_sum);
+        for (int i = 0; i < key_count; i++) {
+                delete[] keys[i];
+                delete[] misses[i];
+        }
+        delete[] keys;
+        delete[] misses;
+        return 0;
+}
+
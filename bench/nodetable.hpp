@@ -0,0 +1,207 @@
+#ifndef NODETABLE_HPP_SENTRY
+#define NODETABLE_HPP_SENTRY
+
+#include <cstring>
+#include "../common.hpp"
+#include "../error.hpp"
+
+template <class T>
+class NodeHashTable {
+        struct Node {
+                T data;
+                const char *key;
+                unsigned long hash;
+                bool is_deleted;
+                Node(const T& val, const char *str, unsigned long h)
+                        : data(val), key(dupstr(str)), hash(h),
+                          is_deleted(false) {}
+                ~Node() { delete[] key; }
+        };
+        Node **array;
+        int array_size;
+        int array_used;
+        int not_deleted;
+        static const int initial_size;
+        static const double rehash_size;
+public:
+        NodeHashTable();
+        ~NodeHashTable();
+        bool Add(const T& data, const char *key);
+        T& FindOrAdd(const T& data, const char *key, bool& added);
+        bool Remove(const char *key);
+        bool Find(const char *key) const;
+        T& operator[](const char *key) const;
+private:
+        NodeHashTable(const NodeHashTable&);
+        void operator=(const NodeHashTable&);
+        int Locate(const char *key, unsigned long hash, int& slot) const;
+        void Insert(int slot, const T& data, const char *key,
+                    unsigned long hash);
+        void Reserve();
+        void Rebuild(int size);
+        static unsigned long Hash(const char *key);
+};
+
+template <class T>
+const int NodeHashTable<T>::initial_size = 8;
+
+template <class T>
+const double NodeHashTable<T>::rehash_size = 0.75;
+
+template <class T>
+NodeHashTable<T>::NodeHashTable()
+{
+        array_size = initial_size;
+        array_used = 0;
+        not_deleted = 0;
+        array = new Node*[initial_size];
+        for (int i = 0; i < array_size; i++)
+                array[i] = 0;
+}
+
+template <class T>
+NodeHashTable<T>::~NodeHashTable()
+{
+        for (int i = 0; i < array_size; i++) {
+                if (array[i])
+                        delete array[i];
+        }
+        delete[] array;
+}
+
+template <class T>
+bool NodeHashTable<T>::Add(const T& data, const char *key)
+{
+        bool added;
+        FindOrAdd(data, key, added);
+        return added;
+}
+
+template <class T>
+T& NodeHashTable<T>::FindOrAdd(const T& data, const char *key, bool& added)
+{
+        Reserve();
+        unsigned long hash = Hash(key);
+        int slot;
+        int idx = Locate(key, hash, slot);
+        added = idx < 0;
+        if (added) {
+                Insert(slot, data, key, hash);
+                idx = slot;
+        }
+        return array[idx]->data;
+}
+
+template <class T>
+bool NodeHashTable<T>::Remove(const char *key)
+{
+        int slot;
+        int idx = Locate(key, Hash(key), slot);
+        if (idx < 0)
+                return false;
+        array[idx]->is_deleted = true;
+        not_deleted--;
+        return true;
+}
+
+template <class T>
+bool NodeHashTable<T>::Find(const char *key) const
+{
+        int slot;
+        return Locate(key, Hash(key), slot) >= 0;
+}
+
+template <class T>
+T& NodeHashTable<T>::operator[](const char *key) const
+{
+        int slot;
+        int idx = Locate(key, Hash(key), slot);
+        if (idx < 0)
+                throw RuntimeError("not found in table", key);
+        return array[idx]->data;
+}
+
+template <class T>
+int NodeHashTable<T>::Locate(const char *key, unsigned long hash,
+                         int& slot) const
+{
+        int mask = array_size - 1;
+        int h1 = hash & mask;
+        int h2 = (hash >> 16 | 1) & mask;
+        slot = -1;
+        for (int i = 0; i < array_size && array[h1]; i++) {
+                Node *node = array[h1];
+                if (node->is_deleted) {
+                        if (slot == -1)
+                                slot = h1;
+                } else if (node->hash == hash && !strcmp(node->key, key)) {
+                        return h1;
+                }
+                h1 = (h1 + h2) & mask;
+        }
+        if (slot == -1)
+                slot = h1;
+        return -1;
+}
+
+template <class T>
+void NodeHashTable<T>::Insert(int slot, const T& data, const char *key,
+                          unsigned long hash)
+{
+        if (array[slot])
+                delete array[slot];
+        else
+                array_used++;
+        array[slot] = new Node(data, key, hash);
+        not_deleted++;
+}
+
+template <class T>
+void NodeHashTable<T>::Reserve()
+{
+        if (not_deleted + 1 > int(rehash_size * array_size))
+                Rebuild(array_size << 1);
+        else if (array_used > 2 * not_deleted)
+                Rebuild(array_size);
+}
+
+template <class T>
+void NodeHashTable<T>::Rebuild(int size)
+{
+        Node **old = array;
+        int old_size = array_size;
+        array_size = size;
+        array_used = not_deleted;
+        array = new Node*[array_size];
+        for (int i = 0; i < array_size; i++)
+                array[i] = 0;
+        int mask = array_size - 1;
+        for (int i = 0; i < old_size; i++) {
+                if (!old[i])
+                        continue;
+                if (old[i]->is_deleted) {
+                        delete old[i];
+                        continue;
+                }
+                int h1 = old[i]->hash & mask;
+                int h2 = (old[i]->hash >> 16 | 1) & mask;
+                while (array[h1])
+                        h1 = (h1 + h2) & mask;
+                array[h1] = old[i];
+        }
+        delete[] old;
+}
+
+template <class T>
+unsigned long NodeHashTable<T>::Hash(const char *key)
+{
+        unsigned long hash = 2166136261UL;
+        for (int i = 0; key[i]; i++) {
+                hash ^= (unsigned char)key[i];
+                hash *= 16777619UL;
+        }
+        return hash;
+}
+
+#endif
+
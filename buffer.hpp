@@ -1,3 +1,7 @@
+#ifndef BUFFER_HPP_SENTRY
+#define BUFFER_HPP_SENTRY
+
+#include <cstddef>
 
 template <class T>
 class Buffer {
@@ -21,3 +25,5 @@ public:
         }
 };
 
+#endif
+
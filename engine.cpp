@@ -1,999 +1,1876 @@
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <cmath>
 #include "engine.hpp"
 #include "error.hpp"
+#include "buffer.hpp"
 
-void RPNElem::Push(RPNItem **stack, RPNElem *unit)
+const RPNOpInfo RPNProgram::info[] = {
+        { "nop", "", "" },
+        { "push_bool", "", "v" },
+        { "push_int", "", "v" },
+        { "push_double", "", "v" },
+        { "push_string", "", "v" },
+        { "push_addr", "", "a" },
+        { "jump", "", "" },
+        { "jump_false", "v", "" },
+        { "alloc", "av", "" },
+        { "free", "a", "" },
+        { "var", "a", "v" },
+        { "inc", "a", "" },
+        { "dec", "a", "" },
+        { "assign", "av", "" },
+        { "index", "av", "a" },
+        { "plus", "vv", "v" },
+        { "minus", "vv", "v" },
+        { "mul", "vv", "v" },
+        { "div", "vv", "v" },
+        { "mod", "vv", "v" },
+        { "uminus", "v", "v" },
+        { "eq", "vv", "v" },
+        { "xor", "vv", "v" },
+        { "or", "vv", "v" },
+        { "and", "vv", "v" },
+        { "not", "v", "v" },
+        { "equ", "vv", "v" },
+        { "neq", "vv", "v" },
+        { "gtr", "vv", "v" },
+        { "lss", "vv", "v" },
+        { "geq", "vv", "v" },
+        { "leq", "vv", "v" },
+        { "print", "", "" },
+        { "scan", "a", "" },
+        { "cast_bool", "v", "v" },
+        { "cast_int", "v", "v" },
+        { "cast_double", "v", "v" },
+        { "cast_string", "v", "v" },
+        { "rand", "v", "v" },
+        { "abs", "v", "v" },
+        { "pow", "vv", "v" },
+        { "sqrt", "v", "v" },
+        { "sin", "v", "v" },
+        { "cos", "v", "v" },
+        { "tan", "v", "v" },
+        { "asin", "v", "v" },
+        { "acos", "v", "v" },
+        { "atan", "v", "v" },
+        { "atan2", "vv", "v" },
+        { "exp", "v", "v" },
+        { "log", "v", "v" },
+        { "ceil", "v", "v" },
+        { "floor", "v", "v" },
+        { "trunc", "v", "v" },
+        { "round", "v", "v" },
+        { "max", "vv", "v" },
+        { "min", "vv", "v" },
+        { "load", "", "v" },
+        { "load_index", "v", "v" },
+        { "addr_index", "v", "a" },
+        { "store", "v", "" },
+        { "assign_int", "", "" },
+        { "inc_var", "", "" },
+        { "dec_var", "", "" },
+        { "load_plus_int", "", "v" },
+        { "load_minus_int", "", "v" },
+        { "load_mul_int", "", "v" },
+        { "load_div_int", "", "v" },
+        { "load_mod_int", "", "v" },
+        { "equ_jump", "vv", "" },
+        { "neq_jump", "vv", "" },
+        { "gtr_jump", "vv", "" },
+        { "lss_jump", "vv", "" },
+        { "geq_jump", "vv", "" },
+        { "leq_jump", "vv", "" },
+        { "plus_int", "vv", "v" },
+        { "minus_int", "vv", "v" },
+        { "mul_int", "vv", "v" },
+        { "div_int", "vv", "v" },
+        { "mod_int", "vv", "v" },
+        { "equ_int", "vv", "v" },
+        { "neq_int", "vv", "v" },
+        { "gtr_int", "vv", "v" },
+        { "lss_int", "vv", "v" },
+        { "geq_int", "vv", "v" },
+        { "leq_int", "vv", "v" },
+        { "equ_jump_int", "vv", "" },
+        { "neq_jump_int", "vv", "" },
+        { "gtr_jump_int", "vv", "" },
+        { "lss_jump_int", "vv", "" },
+        { "geq_jump_int", "vv", "" },
+        { "leq_jump_int", "vv", "" },
+        { "plus_ii", "vv", "v" },
+        { "minus_ii", "vv", "v" },
+        { "mul_ii", "vv", "v" },
+        { "div_ii", "vv", "v" },
+        { "mod_ii", "vv", "v" },
+        { "equ_ii", "vv", "v" },
+        { "neq_ii", "vv", "v" },
+        { "gtr_ii", "vv", "v" },
+        { "lss_ii", "vv", "v" },
+        { "geq_ii", "vv", "v" },
+        { "leq_ii", "vv", "v" },
+        { "equ_jump_ii", "vv", "" },
+        { "neq_jump_ii", "vv", "" },
+        { "gtr_jump_ii", "vv", "" },
+        { "lss_jump_ii", "vv", "" },
+        { "geq_jump_ii", "vv", "" },
+        { "leq_jump_ii", "vv", "" },
+        { "plus_store", "v", "" },
+        { "minus_store", "v", "" },
+        { "mul_store", "v", "" },
+        { "div_store", "v", "" },
+        { "mod_store", "v", "" },
+        { "plus_assign", "av", "" },
+        { "minus_assign", "av", "" },
+        { "mul_assign", "av", "" },
+        { "div_assign", "av", "" },
+        { "mod_assign", "av", "" },
+        { "append", "av", "" },
+        { "copy", "aa", "" },
+        { "map", "avv", "" }
+};
+
+RPNProgram::RPNProgram()
 {
-        RPNItem *tmp = new RPNItem;
-        tmp->elem = unit;
-        tmp->next = *stack;
-        *stack = tmp;
+        size = 0;
+        allocated = 64;
+        depth = 0;
+        line = 0;
+        code = new RPNInstr[allocated];
 }
 
-RPNElem *RPNElem::Pop(RPNItem **stack)
+RPNProgram::~RPNProgram()
 {
-        if (!*stack)
-                return 0;
-        RPNElem *unit = (*stack)->elem;
-        RPNItem *tmp = *stack;
-        *stack = (*stack)->next;
-        delete tmp;
-        return unit;
+        delete[] code;
 }
 
-void RPNJump::Evaluate(RPNItem **cur_cmd, RPNItem **stack,
-                       LabTable& L, VarTable& V) const
+long RPNProgram::Emit(RPNOpCode op, long arg)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNLabel *lab = dynamic_cast<RPNLabel*>(operand1);
-        if (!lab)
-                throw RuntimeError("operand1 not RPNLabel", "RPNJump");
-        *cur_cmd = lab->Get();
-        delete operand1;
+        long idx = Append(op);
+        code[idx].arg.integer = arg;
+        return idx;
 }
 
-void RPNJumpFalse::Evaluate(RPNItem **cur_cmd, RPNItem **stack,
-                            LabTable& L, VarTable& V) const
+long RPNProgram::EmitReal(RPNOpCode op, double arg)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *cond = dynamic_cast<RPNValue*>(operand1);
-        if (!cond)
-                throw RuntimeError("operand1 not RPNValue", "RPNJumpFalse");
-        RPNElem *operand2 = Pop(stack);
-        RPNLabel *lab = dynamic_cast<RPNLabel*>(operand2);
-        if (!lab)
-                throw RuntimeError("operand2 not RPNLabel", "RPNJumpFalse");
-        *cur_cmd = cond->GetBool() ? (*cur_cmd)->next : lab->Get();
-        delete operand1;
-        delete operand2;
+        long idx = Append(op);
+        code[idx].arg.real = arg;
+        return idx;
 }
 
-void RPNConst::Evaluate(RPNItem **cur_cmd, RPNItem **stack,
-                        LabTable& L, VarTable& V) const
+long RPNProgram::EmitString(RPNOpCode op, const char *arg)
 {
-        Push(stack, Clone());
-        *cur_cmd = (*cur_cmd)->next;
+        long idx = Append(op);
+        code[idx].arg.string = strings.Intern(arg);
+        return idx;
 }
 
-void RPNFunction::Evaluate(RPNItem **cur_cmd, RPNItem **stack,
-                           LabTable& L, VarTable& V) const
+long RPNProgram::Append(RPNOpCode op)
 {
-        RPNElem *retval = Call(stack, L, V);
-        if (retval)
-                Push(stack, retval);
-        *cur_cmd = (*cur_cmd)->next;
+        if (size == allocated) {
+                allocated <<= 1;
+                RPNInstr *tmp = new RPNInstr[allocated];
+                memcpy(tmp, code, size * sizeof(*code));
+                delete[] code;
+                code = tmp;
+        }
+        code[size].op = op;
+        code[size].line = line;
+        code[size].slot = 0;
+        return size++;
 }
 
-RPNElem *RPNFunNull::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+void RPNProgram::Verify()
 {
-        return 0;
+        Buffer<bool> target;
+        Buffer<char> kinds;
+        for (long i = 0; i <= size; i++)
+                target[i] = false;
+        for (long i = 0; i < size; i++) {
+                if (!IsJump(code[i].op))
+                        continue;
+                if (code[i].arg.integer < 0 || code[i].arg.integer > size)
+                        throw SyntaxError("jump out of program", code[i].line);
+                target[code[i].arg.integer] = true;
+        }
+        long sp = 0;
+        depth = 0;
+        for (long i = 0; i < size; i++) {
+                if (target[i] && sp != 0)
+                        throw SyntaxError("stack not empty at jump target",
+                                          code[i].line);
+                const char *pops = info[code[i].op].pops;
+                long count = Pops(i);
+                if (sp < count)
+                        throw SyntaxError("stack underflow", code[i].line);
+                sp -= count;
+                for (long j = 0; j < count; j++) {
+                        char kind = *pops ? pops[j] : 'v';
+                        if (kinds[sp + j] != kind)
+                                throw SyntaxError("operand kind mismatch",
+                                                  code[i].line);
+                }
+                for (const char *p = info[code[i].op].pushes; *p; p++)
+                        kinds[sp++] = *p;
+                if (sp > depth)
+                        depth = sp;
+                if (IsJump(code[i].op) && sp != 0)
+                        throw SyntaxError("stack not empty at jump",
+                                          code[i].line);
+        }
+        if (sp != 0)
+                throw SyntaxError("stack not empty at end of program", line);
 }
 
-RPNElem *RPNFunAlloc::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+void RPNProgram::Compact()
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *size = dynamic_cast<RPNValue*>(operand1);
-        if (!size)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunAlloc");
-        RPNElem *operand2 = Pop(stack);
-        RPNAddr *addr = dynamic_cast<RPNAddr*>(operand2);
-        if (!addr)
-                throw RuntimeError("operand2 not RPNAddr", "RPNFunAlloc");
-        V.Alloc(addr->Name(), size->GetInt());
-        delete operand1;
-        delete operand2;
-        return 0;
+        Buffer<long> moved;
+        long count = 0;
+        for (long i = 0; i < size; i++) {
+                moved[i] = count;
+                if (code[i].op != rpn_nop)
+                        code[count++] = code[i];
+        }
+        moved[size] = count;
+        size = count;
+        for (long i = 0; i < size; i++) {
+                if (IsJump(code[i].op))
+                        code[i].arg.integer = moved[code[i].arg.integer];
+        }
 }
 
-RPNElem *RPNFunFree::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+int RPNProgram::OpCount()
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNAddr *addr = dynamic_cast<RPNAddr*>(operand1);
-        if (!addr)
-                throw RuntimeError("operand1 not RPNAddr", "RPNFunFree");
-        V.Free(addr->Name());
-        delete operand1;
-        return 0;
+        return sizeof(info) / sizeof(*info);
 }
 
-RPNElem *RPNFunLab::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+long RPNProgram::Pops(long idx) const
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *name = dynamic_cast<RPNValue*>(operand1);
-        if (!name)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunLab");
-        RPNItem *addr = L.GetLabel(name->GetString());
-        delete operand1;
-        return new RPNLabel(addr);
+        if (code[idx].op == rpn_print)
+                return code[idx].arg.integer;
+        return strlen(info[code[idx].op].pops);
 }
 
-RPNElem *RPNFunVar::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+long RPNProgram::Pushes(long idx) const
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNAddr *addr = dynamic_cast<RPNAddr*>(operand1);
-        if (!addr)
-                throw RuntimeError("operand1 not RPNAddr", "RPNFunVar");
-        RPNValue *retval = V.GetValue(addr->Name(), addr->Index());
-        delete operand1;
-        return retval;
+        return strlen(info[code[idx].op].pushes);
 }
 
-RPNElem *RPNFunInc::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+bool RPNProgram::IsJump(RPNOpCode op)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNAddr *addr = dynamic_cast<RPNAddr*>(operand1);
-        if (!addr)
-                throw RuntimeError("operand1 not RPNAddr", "RPNFunInc");
-        RPNValue *value = V.GetValue(addr->Name(), addr->Index());
-        RPNValue *q = new RPNValue(value->GetInt() + 1);
-        V.SetValue(addr->Name(), addr->Index(), q);
-        delete operand1;
-        delete value;
-        delete q;
-        return 0;
+        switch (op) {
+        case rpn_jump:
+        case rpn_jump_false:
+        case rpn_equ_jump:
+        case rpn_neq_jump:
+        case rpn_gtr_jump:
+        case rpn_lss_jump:
+        case rpn_geq_jump:
+        case rpn_leq_jump:
+        case rpn_equ_jump_int:
+        case rpn_neq_jump_int:
+        case rpn_gtr_jump_int:
+        case rpn_lss_jump_int:
+        case rpn_geq_jump_int:
+        case rpn_leq_jump_int:
+        case rpn_equ_jump_ii:
+        case rpn_neq_jump_ii:
+        case rpn_gtr_jump_ii:
+        case rpn_lss_jump_ii:
+        case rpn_geq_jump_ii:
+        case rpn_leq_jump_ii:
+                return true;
+        default:
+                return false;
+        }
 }
-
-RPNElem *RPNFunDec::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNAddr *addr = dynamic_cast<RPNAddr*>(operand1);
-        if (!addr)
-                throw RuntimeError("operand1 not RPNAddr", "RPNFunDec");
-        RPNValue *value = V.GetValue(addr->Name(), addr->Index());
-        RPNValue *q = new RPNValue(value->GetInt() - 1);
-        V.SetValue(addr->Name(), addr->Index(), q);
-        delete operand1;
-        delete value;
-        delete q;
-        return 0;
+
+void RPNProgram::Remove(long idx)
+{
+        code[idx].op = rpn_nop;
 }
 
-RPNElem *RPNFunAssign::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+void RPNProgram::SetConstant(long idx, const Value& val)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *value = dynamic_cast<RPNValue*>(operand1);
-        if (!value)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunAssign");
-        RPNElem *operand2 = Pop(stack);
-        RPNAddr *addr = dynamic_cast<RPNAddr*>(operand2);
-        if (!addr)
-                throw RuntimeError("operand2 not RPNAddr", "RPNFunAssign");
-        V.SetValue(addr->Name(), addr->Index(), value);
-        delete operand1;
-        delete operand2;
-        return 0;
-};
+        Remove(idx);
+        switch (val.Type()) {
+        case bool_type:
+                code[idx].op = rpn_push_bool;
+                code[idx].arg.integer = val.Bool();
+                break;
+        case int_type:
+                code[idx].op = rpn_push_int;
+                code[idx].arg.integer = val.Int();
+                break;
+        case double_type:
+                code[idx].op = rpn_push_double;
+                code[idx].arg.real = val.Double();
+                break;
+        case string_type:
+                code[idx].op = rpn_push_string;
+                code[idx].arg.string =
+                        strings.Intern(val.String(), val.Length());
+                break;
+        }
+}
+
+bool RPNProgram::IsConstant(RPNOpCode op)
+{
+        return op == rpn_push_bool || op == rpn_push_int ||
+               op == rpn_push_double || op == rpn_push_string;
+}
+
+RPNStack::RPNStack(long capacity)
+{
+        data = new Value[capacity];
+        sp = 0;
+}
+
+static void FunAlloc(RPNStack& stack, VarTable& V)
+{
+        const Value& size = stack.Pop();
+        const Value& addr = stack.Pop();
+        V.Alloc(addr.Slot(), size.GetInt());
+}
+
+static void FunFree(RPNStack& stack, VarTable& V)
+{
+        const Value& addr = stack.Pop();
+        V.Free(addr.Slot());
+}
+
+static void FunVar(RPNStack& stack, VarTable& V)
+{
+        Value& top = stack.Top();
+        V.GetValue(top.Slot(), top.Index(), top);
+}
+
+static void Step(VarTable& V, long slot, long index, long delta)
+{
+        V.Lookup(slot).Step(index, delta);
+}
+
+static void FunInc(RPNStack& stack, VarTable& V)
+{
+        const Value& addr = stack.Pop();
+        Step(V, addr.Slot(), addr.Index(), 1);
+}
+
+static void FunDec(RPNStack& stack, VarTable& V)
+{
+        const Value& addr = stack.Pop();
+        Step(V, addr.Slot(), addr.Index(), -1);
+}
+
+static void FunAssign(RPNStack& stack, VarTable& V)
+{
+        const Value& value = stack.Pop();
+        const Value& addr = stack.Pop();
+        V.SetValue(addr.Slot(), addr.Index(), value);
+}
+
+static void FunAppend(RPNStack& stack, VarTable& V)
+{
+        const Value& value = stack.Pop();
+        const Value& addr = stack.Pop();
+        V.Append(addr.Slot(), value);
+}
+
+static void FunCopy(RPNStack& stack, VarTable& V)
+{
+        const Value& src = stack.Pop();
+        const Value& dst = stack.Pop();
+        V.Copy(dst.Slot(), src.Slot());
+}
+
+static void FunMap(RPNStack& stack, VarTable& V, long type)
+{
+        const Value& size = stack.Pop();
+        const Value& name = stack.Pop();
+        const Value& addr = stack.Pop();
+        V.Map(addr.Slot(), name.GetString(), DataType(type), size.GetInt());
+}
+
+static void FunIndex(RPNStack& stack)
+{
+        const Value& index = stack.Pop();
+        Value& addr = stack.Top();
+        addr.SetAddr(addr.Slot(), index.GetInt());
+}
+
+static void FunLoad(RPNStack& stack, VarTable& V, long slot)
+{
+        V.GetValue(slot, 0, stack.Push());
+}
+
+static void FunLoadIndex(RPNStack& stack, VarTable& V, long slot)
+{
+        Value& top = stack.Top();
+        V.GetValue(slot, top.GetInt(), top);
+}
+
+static void FunAddrIndex(RPNStack& stack, long slot)
+{
+        Value& top = stack.Top();
+        top.SetAddr(slot, top.GetInt());
+}
+
+static void FunStore(RPNStack& stack, VarTable& V, long slot)
+{
+        const Value& value = stack.Pop();
+        V.SetValue(slot, 0, value);
+}
+
+static void FunAssignInt(VarTable& V, long slot, long val)
+{
+        Value value;
+        value.Set(val);
+        V.SetValue(slot, 0, value);
+}
+
+static Value& LoadInt(RPNStack& stack, VarTable& V, long slot,
+                         const char *fun)
+{
+        Value& top = stack.Push();
+        V.GetValue(slot, 0, top);
+        if (top.Type() != int_type)
+                throw RuntimeError("data type mismatch", fun);
+        return top;
+}
+
+static void FunLoadPlusInt(RPNStack& stack, VarTable& V, const RPNInstr& cmd)
+{
+        Value& top = LoadInt(stack, V, cmd.slot, "RPNFunPlus");
+        top.Set(top.Int() + cmd.arg.integer);
+}
+
+static void FunLoadMinusInt(RPNStack& stack, VarTable& V, const RPNInstr& cmd)
+{
+        Value& top = LoadInt(stack, V, cmd.slot, "RPNFunMinus");
+        top.Set(top.Int() - cmd.arg.integer);
+}
+
+static void FunLoadMulInt(RPNStack& stack, VarTable& V, const RPNInstr& cmd)
+{
+        Value& top = LoadInt(stack, V, cmd.slot, "RPNFunMul");
+        top.Set(top.Int() * cmd.arg.integer);
+}
 
-RPNElem *RPNFunIndex::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *index = dynamic_cast<RPNValue*>(operand1);
-        if (!index)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunIndex");
-        RPNElem *operand2 = Pop(stack);
-        RPNAddr *addr = dynamic_cast<RPNAddr*>(operand2);
-        if (!addr)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunIndex");
-        RPNElem *retval = new RPNAddr(addr->Name(), index->GetInt());
-        delete operand1;
-        delete operand2;
-        return retval;
-}
-
-RPNElem *RPNFunPlus::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunPlus");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *i2 = dynamic_cast<RPNValue*>(operand2);
-        if (!i2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunPlus");
-        RPNElem *retval;
-        const char *str;
-        if (i1->Type() != i2->Type())
+static void FunLoadDivInt(RPNStack& stack, VarTable& V, const RPNInstr& cmd)
+{
+        Value& top = LoadInt(stack, V, cmd.slot, "RPNFunDiv");
+        top.Set(top.Int() / cmd.arg.integer);
+}
+
+static void FunLoadModInt(RPNStack& stack, VarTable& V, const RPNInstr& cmd)
+{
+        Value& top = LoadInt(stack, V, cmd.slot, "RPNFunMod");
+        top.Set(top.Int() % cmd.arg.integer);
+}
+
+static void Add(Value& i2, const Value& i1, Arena *arena)
+{
+        if (i1.Type() != i2.Type())
                 throw RuntimeError("data type mismatch", "RPNFunPlus");
-        switch (i1->Type()) {
+        switch (i1.Type()) {
         case int_type:
-                retval = new RPNValue(i2->GetInt() + i1->GetInt());
+                i2.Set(i2.Int() + i1.Int());
                 break;
         case double_type:
-                retval = new RPNValue(i2->GetDouble() + i1->GetDouble());
+                i2.Set(i2.Double() + i1.Double());
                 break;
         case string_type:
-                str = concatenate(i2->GetString(), i1->GetString());
-                retval = new RPNValue(str);
-                delete []str;
+                i2.Append(i1, arena);
                 break;
         default:
                 throw RuntimeError("data type mismatch", "RPNFunPlus");
         }
-        delete operand1;
-        delete operand2;
-        return retval;
-}
-
-RPNElem *RPNFunMinus::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunMinus");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *i2 = dynamic_cast<RPNValue*>(operand2);
-        if (!i2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunMinus");
-        if (i1->Type() != i2->Type())
+}
+
+static void FunPlus(RPNStack& stack, Arena *arena)
+{
+        const Value& i1 = stack.Pop();
+        Add(stack.Top(), i1, arena);
+}
+
+
+static void Sub(Value& i2, const Value& i1)
+{
+        if (i1.Type() != i2.Type())
                 throw RuntimeError("data type mismatch", "RPNFunMinus");
-        RPNElem *retval;
-        switch (i1->Type()) {
+        switch (i1.Type()) {
         case int_type:
-                retval = new RPNValue(i2->GetInt() - i1->GetInt());
+                i2.Set(i2.Int() - i1.Int());
                 break;
         case double_type:
-                retval = new RPNValue(i2->GetDouble() - i1->GetDouble());
+                i2.Set(i2.Double() - i1.Double());
                 break;
         default:
                 throw RuntimeError("data type mismatch", "RPNFunMinus");
         }
-        delete operand1;
-        delete operand2;
-        return retval;
-}
-
-RPNElem *RPNFunMul::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunMul");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *i2 = dynamic_cast<RPNValue*>(operand2);
-        if (!i2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunMul");
-        if (i1->Type() != i2->Type())
+}
+
+static void FunMinus(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Sub(stack.Top(), i1);
+}
+
+static void Mul(Value& i2, const Value& i1)
+{
+        if (i1.Type() != i2.Type())
                 throw RuntimeError("data type mismatch", "RPNFunMul");  
-        RPNElem *retval;
-        switch (i1->Type()) {
+        switch (i1.Type()) {
         case int_type:
-                retval = new RPNValue(i2->GetInt() * i1->GetInt());
+                i2.Set(i2.Int() * i1.Int());
                 break;
         case double_type:
-                retval = new RPNValue(i2->GetDouble() * i1->GetDouble());
+                i2.Set(i2.Double() * i1.Double());
                 break;
         default:
                 throw RuntimeError("data type mismatch", "RPNFunMul");
         }
-        delete operand1;
-        delete operand2;
-        return retval;
-}
-
-RPNElem *RPNFunDiv::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunDiv");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *i2 = dynamic_cast<RPNValue*>(operand2);
-        if (!i2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunDiv");
-        if (i1->Type() != i2->Type())
+}
+
+static void FunMul(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Mul(stack.Top(), i1);
+}
+
+static void Div(Value& i2, const Value& i1)
+{
+        if (i1.Type() != i2.Type())
                 throw RuntimeError("data type mismatch", "RPNFunDiv");  
-        RPNElem *retval;
-        switch (i1->Type()) {
+        switch (i1.Type()) {
         case int_type:
-                if (!i1->GetInt())
+                if (!i1.Int())
                         throw RuntimeError("division by zero", "RPNFunDiv");
-                retval = new RPNValue(i2->GetInt() / i1->GetInt());
+                i2.Set(i2.Int() / i1.Int());
                 break;
         case double_type:
-                if (!i1->GetDouble())
+                if (!i1.Double())
                         throw RuntimeError("division by zero", "RPNFunDiv");
-                retval = new RPNValue(i2->GetDouble() / i1->GetDouble());
+                i2.Set(i2.Double() / i1.Double());
                 break;
         default:
                 throw RuntimeError("data type mismatch", "RPNFunDiv");
         }
-        delete operand1;
-        delete operand2;
-        return retval;
-}
-
-RPNElem *RPNFunMod::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunMod");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *i2 = dynamic_cast<RPNValue*>(operand2);
-        if (!i2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunMod");
-        if (i1->Type() != i2->Type())
+}
+
+static void FunDiv(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Div(stack.Top(), i1);
+}
+
+static void Mod(Value& i2, const Value& i1)
+{
+        if (i1.Type() != i2.Type())
                 throw RuntimeError("data type mismatch", "RPNFunMod");
-        if (!i1->GetInt())
+        long divisor = i1.GetInt();
+        if (!divisor)
                 throw RuntimeError("modulo by zero", "RPNFunMod");
-        long res = i2->GetInt() % i1->GetInt();
-        delete operand1;
-        delete operand2;
-        return new RPNValue(res);
+        long res = i2.Int() % divisor;
+        i2.Set(res);
+}
+
+static void FunMod(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Mod(stack.Top(), i1);
+}
+
+static void AddTo(Value& i2, const Value& i1)
+{
+        Add(i2, i1, 0);
+}
+
+typedef void (*Update)(Value& i2, const Value& i1);
+
+static void Apply(Array& arr, long index, Update fun, const Value& i1)
+{
+        Value *ref = arr.Ref(index);
+        if (ref) {
+                fun(*ref, i1);
+                return;
+        }
+        Value val;
+        arr.Get(index, val);
+        fun(val, i1);
+        arr.Set(index, val);
+}
+
+static void FunUpdateVar(RPNStack& stack, VarTable& V, long slot, Update fun)
+{
+        const Value& i1 = stack.Pop();
+        Apply(V.Lookup(slot), 0, fun, i1);
+}
+
+static void FunUpdate(RPNStack& stack, VarTable& V, Update fun)
+{
+        const Value& i1 = stack.Pop();
+        const Value& addr = stack.Pop();
+        Apply(V.Lookup(addr.Slot()), addr.Index(), fun, i1);
 }
 
-RPNElem *RPNFunUMinus::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunUMinus(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunUMinus");
-        RPNElem *retval;
-        switch (i1->Type()) {
+        Value& i1 = stack.Top();
+        switch (i1.Type()) {
         case int_type:
-                retval = new RPNValue(-i1->GetInt());
+                i1.Set(-i1.Int());
                 break;
         case double_type:
-                retval = new RPNValue(-i1->GetDouble());
+                i1.Set(-i1.Double());
                 break;
         default:
                 throw RuntimeError("data type mismatch", "RPNFunUMinus");
         }
-        delete operand1;
-        return retval;
-}
-
-RPNElem *RPNFunEQ::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *b1 = dynamic_cast<RPNValue*>(operand1);
-        if (!b1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunEQ");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *b2 = dynamic_cast<RPNValue*>(operand2);
-        if (!b2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunEQ");
-        bool res = (b2->GetBool() && b1->GetBool()) ||
-                   (!b2->GetBool() && !b1->GetBool());
-        delete operand1;
-        delete operand2;
-        return new RPNValue(res);
-}
-
-RPNElem *RPNFunXOR::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *b1 = dynamic_cast<RPNValue*>(operand1);
-        if (!b1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunXOR");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *b2 = dynamic_cast<RPNValue*>(operand2);
-        if (!b2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunXOR");
-        bool res = (b2->GetBool() && !b1->GetBool()) ||
-                   (!b2->GetBool() && b1->GetBool());
-        delete operand1;
-        delete operand2;
-        return new RPNValue(res);
-}
-
-RPNElem *RPNFunOR::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *b1 = dynamic_cast<RPNValue*>(operand1);
-        if (!b1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunOR");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *b2 = dynamic_cast<RPNValue*>(operand2);
-        if (!b2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunOR");
-        bool res = b2->GetBool() || b1->GetBool();
-        delete operand1;
-        delete operand2;
-        return new RPNValue(res);
-}
-
-RPNElem *RPNFunAND::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *b1 = dynamic_cast<RPNValue*>(operand1);
-        if (!b1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunAND");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *b2 = dynamic_cast<RPNValue*>(operand2);
-        if (!b2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunAND");
-        bool res = b2->GetBool() && b1->GetBool();
-        delete operand1;
-        delete operand2;
-        return new RPNValue(res);
-}
-
-RPNElem *RPNFunNOT::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *b1 = dynamic_cast<RPNValue*>(operand1);
-        if (!b1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunNOT");
-        bool res = !b1->GetBool();
-        delete operand1;
-        return new RPNValue(res);
-}
-
-RPNElem *RPNFunEQU::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunEQU");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *i2 = dynamic_cast<RPNValue*>(operand2);
-        if (!i2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunEQU");
-        if (i1->Type() != i2->Type())
-                throw RuntimeError("data type mismatch", "RPNFunNEQ");  
-        bool res;
-        switch (i1->Type()) {
+}
+
+static void FunEQ(RPNStack& stack)
+{
+        const Value& b1 = stack.Pop();
+        Value& b2 = stack.Top();
+        bool res = b2.GetBool() == b1.GetBool();
+        b2.Set(res);
+}
+
+static void FunXOR(RPNStack& stack)
+{
+        const Value& b1 = stack.Pop();
+        Value& b2 = stack.Top();
+        bool res = b2.GetBool() != b1.GetBool();
+        b2.Set(res);
+}
+
+static void FunOR(RPNStack& stack)
+{
+        const Value& b1 = stack.Pop();
+        Value& b2 = stack.Top();
+        bool res = b2.GetBool() || b1.GetBool();
+        b2.Set(res);
+}
+
+static void FunAND(RPNStack& stack)
+{
+        const Value& b1 = stack.Pop();
+        Value& b2 = stack.Top();
+        bool res = b2.GetBool() && b1.GetBool();
+        b2.Set(res);
+}
+
+static void FunNOT(RPNStack& stack)
+{
+        Value& b1 = stack.Top();
+        bool res = !b1.GetBool();
+        b1.Set(res);
+}
+
+static bool CmpEQU(const Value& i2, const Value& i1)
+{
+        if (i1.Type() != i2.Type())
+                throw RuntimeError("data type mismatch", "RPNFunNEQ");
+        switch (i1.Type()) {
         case bool_type:
-                res = i2->GetBool() == i1->GetBool();
-                break;
+                return i2.Bool() == i1.Bool();
         case int_type:
-                res = i2->GetInt() == i1->GetInt();
-                break;
+                return i2.Int() == i1.Int();
         case double_type:
-                res = i2->GetDouble() == i1->GetDouble();
-                break;
+                return i2.Double() == i1.Double();
         case string_type:
-                res = strcmp(i2->GetString(), i1->GetString()) == 0;
-                break;
+                return strcmp(i2.String(), i1.String()) == 0;
         }
-        delete operand1;
-        delete operand2;
-        return new RPNValue(res);
-}
-
-RPNElem *RPNFunNEQ::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunNEQ");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *i2 = dynamic_cast<RPNValue*>(operand2);
-        if (!i2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunNEQ");
-        if (i1->Type() != i2->Type())
-                throw RuntimeError("data type mismatch", "RPNFunNEQ");  
-        bool res;
-        switch (i1->Type()) {
+        return false;
+}
+
+static void FunEQU(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        bool res = CmpEQU(i2, i1);
+        i2.Set(res);
+}
+
+static bool CmpNEQ(const Value& i2, const Value& i1)
+{
+        if (i1.Type() != i2.Type())
+                throw RuntimeError("data type mismatch", "RPNFunNEQ");
+        switch (i1.Type()) {
         case bool_type:
-                res = i2->GetBool() != i1->GetBool();
-                break;
+                return i2.Bool() != i1.Bool();
         case int_type:
-                res = i2->GetInt() != i1->GetInt();
-                break;
+                return i2.Int() != i1.Int();
         case double_type:
-                res = i2->GetDouble() != i1->GetDouble();
-                break;
+                return i2.Double() != i1.Double();
         case string_type:
-                res = strcmp(i2->GetString(), i1->GetString()) != 0;
-                break;
+                return strcmp(i2.String(), i1.String()) != 0;
         }
-        delete operand1;
-        delete operand2;
-        return new RPNValue(res);
-}
-
-RPNElem *RPNFunGTR::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunGTR");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *i2 = dynamic_cast<RPNValue*>(operand2);
-        if (!i2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunGTR");
-        if (i1->Type() != i2->Type())
-                throw RuntimeError("data type mismatch", "RPNFunGTR");  
-        bool res;
-        switch (i1->Type()) {
+        return false;
+}
+
+static void FunNEQ(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        bool res = CmpNEQ(i2, i1);
+        i2.Set(res);
+}
+
+static bool CmpGTR(const Value& i2, const Value& i1)
+{
+        if (i1.Type() != i2.Type())
+                throw RuntimeError("data type mismatch", "RPNFunGTR");
+        switch (i1.Type()) {
         case bool_type:
-                res = i2->GetBool() > i1->GetBool();
-                break;
+                return i2.Bool() > i1.Bool();
         case int_type:
-                res = i2->GetInt() > i1->GetInt();
-                break;
+                return i2.Int() > i1.Int();
         case double_type:
-                res = i2->GetDouble() > i1->GetDouble();
-                break;
+                return i2.Double() > i1.Double();
         case string_type:
-                res = strcmp(i2->GetString(), i1->GetString()) > 0;
-                break;
+                return strcmp(i2.String(), i1.String()) > 0;
         }
-        delete operand1;
-        delete operand2;
-        return new RPNValue(res);
-}
-
-RPNElem *RPNFunLSS::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunLSS");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *i2 = dynamic_cast<RPNValue*>(operand2);
-        if (!i2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunLSS");
-        if (i1->Type() != i2->Type())
-                throw RuntimeError("data type mismatch", "RPNFunLSS");  
-        bool res;
-        switch (i1->Type()) {
+        return false;
+}
+
+static void FunGTR(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        bool res = CmpGTR(i2, i1);
+        i2.Set(res);
+}
+
+static bool CmpLSS(const Value& i2, const Value& i1)
+{
+        if (i1.Type() != i2.Type())
+                throw RuntimeError("data type mismatch", "RPNFunLSS");
+        switch (i1.Type()) {
         case bool_type:
-                res = i2->GetBool() < i1->GetBool();
-                break;
+                return i2.Bool() < i1.Bool();
         case int_type:
-                res = i2->GetInt() < i1->GetInt();
-                break;
+                return i2.Int() < i1.Int();
         case double_type:
-                res = i2->GetDouble() < i1->GetDouble();
-                break;
+                return i2.Double() < i1.Double();
         case string_type:
-                res = strcmp(i2->GetString(), i1->GetString()) < 0;
-                break;
+                return strcmp(i2.String(), i1.String()) < 0;
         }
-        delete operand1;
-        delete operand2;
-        return new RPNValue(res);
-}
-
-RPNElem *RPNFunGEQ::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunGEQ");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *i2 = dynamic_cast<RPNValue*>(operand2);
-        if (!i2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunGEQ");
-        if (i1->Type() != i2->Type())
-                throw RuntimeError("data type mismatch", "RPNFunGEQ");  
-        bool res;
-        switch (i1->Type()) {
+        return false;
+}
+
+static void FunLSS(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        bool res = CmpLSS(i2, i1);
+        i2.Set(res);
+}
+
+static bool CmpGEQ(const Value& i2, const Value& i1)
+{
+        if (i1.Type() != i2.Type())
+                throw RuntimeError("data type mismatch", "RPNFunGEQ");
+        switch (i1.Type()) {
         case bool_type:
-                res = i2->GetBool() >= i1->GetBool();
-                break;
+                return i2.Bool() >= i1.Bool();
         case int_type:
-                res = i2->GetInt() >= i1->GetInt();
-                break;
+                return i2.Int() >= i1.Int();
         case double_type:
-                res = i2->GetDouble() >= i1->GetDouble();
-                break;
+                return i2.Double() >= i1.Double();
         case string_type:
-                res = strcmp(i2->GetString(), i1->GetString()) >= 0;
-                break;
+                return strcmp(i2.String(), i1.String()) >= 0;
         }
-        delete operand1;
-        delete operand2;
-        return new RPNValue(res);
-}
-
-RPNElem *RPNFunLEQ::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunLEQ");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *i2 = dynamic_cast<RPNValue*>(operand2);
-        if (!i2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunLEQ");
-        if (i1->Type() != i2->Type())
-                throw RuntimeError("data type mismatch", "RPNFunLEQ");  
-        bool res;
-        switch (i1->Type()) {
+        return false;
+}
+
+static void FunGEQ(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        bool res = CmpGEQ(i2, i1);
+        i2.Set(res);
+}
+
+static bool CmpLEQ(const Value& i2, const Value& i1)
+{
+        if (i1.Type() != i2.Type())
+                throw RuntimeError("data type mismatch", "RPNFunLEQ");
+        switch (i1.Type()) {
         case bool_type:
-                res = i2->GetBool() <= i1->GetBool();
-                break;
+                return i2.Bool() <= i1.Bool();
         case int_type:
-                res = i2->GetInt() <= i1->GetInt();
-                break;
+                return i2.Int() <= i1.Int();
         case double_type:
-                res = i2->GetDouble() <= i1->GetDouble();
-                break;
+                return i2.Double() <= i1.Double();
         case string_type:
-                res = strcmp(i2->GetString(), i1->GetString()) <= 0;
-                break;
+                return strcmp(i2.String(), i1.String()) <= 0;
         }
-        delete operand1;
-        delete operand2;
-        return new RPNValue(res);
+        return false;
 }
 
-RPNElem *RPNFunPrint::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunLEQ(RPNStack& stack)
 {
-        RPNElem *operand;
-        RPNItem *tmp, *arg_list = 0;
-        while ((operand = Pop(stack))) {
-                tmp = new RPNItem;
-                tmp->elem = operand;
-                tmp->next = arg_list;
-                arg_list = tmp;
-        }
-        while (arg_list) {
-                tmp = arg_list;
-                arg_list = arg_list->next;
-                RPNValue *val = dynamic_cast<RPNValue*>(tmp->elem);
-                if (!val)
-                        throw RuntimeError("RPNValue", "RPNFunPrint");
-                printf("%s", val->GetString());
-                delete tmp->elem;
-                delete tmp;
-        }
-        return 0;
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        bool res = CmpLEQ(i2, i1);
+        i2.Set(res);
 }
 
-RPNElem *RPNFunScan::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static bool FunEQUJump(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNAddr *i1 = dynamic_cast<RPNAddr*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNAddr", "RPNFunScan");
+        const Value *args = stack.Pop(2);
+        return !CmpEQU(args[0], args[1]);
+}
+
+static bool FunNEQJump(RPNStack& stack)
+{
+        const Value *args = stack.Pop(2);
+        return !CmpNEQ(args[0], args[1]);
+}
+
+static bool FunGTRJump(RPNStack& stack)
+{
+        const Value *args = stack.Pop(2);
+        return !CmpGTR(args[0], args[1]);
+}
+
+static bool FunLSSJump(RPNStack& stack)
+{
+        const Value *args = stack.Pop(2);
+        return !CmpLSS(args[0], args[1]);
+}
+
+static bool FunGEQJump(RPNStack& stack)
+{
+        const Value *args = stack.Pop(2);
+        return !CmpGEQ(args[0], args[1]);
+}
+
+static bool FunLEQJump(RPNStack& stack)
+{
+        const Value *args = stack.Pop(2);
+        return !CmpLEQ(args[0], args[1]);
+}
+
+static bool BothInt(RPNStack& stack)
+{
+        return stack.Peek(0).Type() == int_type &&
+               stack.Peek(1).Type() == int_type;
+}
+
+static void Quicken(RPNStack& stack, RPNInstr& cmd, RPNOpCode op)
+{
+        if (BothInt(stack))
+                cmd.op = op;
+}
+
+static bool Guard(RPNStack& stack, RPNInstr& cmd, RPNOpCode op)
+{
+        if (BothInt(stack))
+                return true;
+        cmd.op = op;
+        return false;
+}
+
+static void FunPlusII(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        i2.SetInt(i2.Int() + i1.Int());
+}
+
+static void FunMinusII(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        i2.SetInt(i2.Int() - i1.Int());
+}
+
+static void FunMulII(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        i2.SetInt(i2.Int() * i1.Int());
+}
+
+static void FunDivII(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        if (!i1.Int())
+                throw RuntimeError("division by zero", "RPNFunDiv");
+        i2.SetInt(i2.Int() / i1.Int());
+}
+
+static void FunModII(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        if (!i1.Int())
+                throw RuntimeError("modulo by zero", "RPNFunMod");
+        i2.SetInt(i2.Int() % i1.Int());
+}
+
+static void FunEQUII(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        i2.Set(i2.Int() == i1.Int());
+}
+
+static void FunNEQII(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        i2.Set(i2.Int() != i1.Int());
+}
+
+static void FunGTRII(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        i2.Set(i2.Int() > i1.Int());
+}
+
+static void FunLSSII(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        i2.Set(i2.Int() < i1.Int());
+}
+
+static void FunGEQII(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        i2.Set(i2.Int() >= i1.Int());
+}
+
+static void FunLEQII(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        i2.Set(i2.Int() <= i1.Int());
+}
+
+static bool FunEQUJumpII(RPNStack& stack)
+{
+        const Value *args = stack.Pop(2);
+        return !(args[0].Int() == args[1].Int());
+}
+
+static bool FunNEQJumpII(RPNStack& stack)
+{
+        const Value *args = stack.Pop(2);
+        return !(args[0].Int() != args[1].Int());
+}
+
+static bool FunGTRJumpII(RPNStack& stack)
+{
+        const Value *args = stack.Pop(2);
+        return !(args[0].Int() > args[1].Int());
+}
+
+static bool FunLSSJumpII(RPNStack& stack)
+{
+        const Value *args = stack.Pop(2);
+        return !(args[0].Int() < args[1].Int());
+}
+
+static bool FunGEQJumpII(RPNStack& stack)
+{
+        const Value *args = stack.Pop(2);
+        return !(args[0].Int() >= args[1].Int());
+}
+
+static bool FunLEQJumpII(RPNStack& stack)
+{
+        const Value *args = stack.Pop(2);
+        return !(args[0].Int() <= args[1].Int());
+}
+
+static void FunPrint(RPNStack& stack, long count)
+{
+        const Value *args = stack.Pop(count);
+        for (long i = 0; i < count; i++)
+                printf("%s", args[i].GetString());
+}
+
+static void FunScan(RPNStack& stack, VarTable& V)
+{
+        const Value& addr = stack.Pop();
         char buff[1024];
         fgets(buff, 1023, stdin);
         buff[strlen(buff) - 1] = 0;
-        RPNValue *val = new RPNValue(buff);
-        V.SetValue(i1->Name(), i1->Index(), val);
-        delete val;
-        delete operand1;
-        return 0;
+        Value val(buff);
+        V.SetValue(addr.Slot(), addr.Index(), val);
 }
 
-RPNElem *RPNFunCastBool::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunCastBool(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunCastBool");
-        bool res;
-        switch (i1->Type()) {
+        Value& i1 = stack.Top();
+        bool res = false;
+        switch (i1.Type()) {
         case bool_type:
-                res = i1->GetBool();
+                res = i1.Bool();
                 break;
         case int_type:
-                res = static_cast<bool>(i1->GetInt());
+                res = static_cast<bool>(i1.Int());
                 break;
         case double_type:
-                res = static_cast<bool>(i1->GetDouble());
+                res = static_cast<bool>(i1.Double());
                 break;
         case string_type:
-                res = !strcmp(i1->GetString(), "true");
+                res = !strcmp(i1.String(), "true");
                 break;
         }
-        delete operand1;
-        return new RPNValue(res);
+        i1.Set(res);
 }
 
-RPNElem *RPNFunCastInt::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunCastInt(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunCastInt");
-        long res;
-        switch (i1->Type()) {
+        Value& i1 = stack.Top();
+        long res = 0;
+        switch (i1.Type()) {
         case bool_type:
-                res = static_cast<long>(i1->GetBool());
+                res = static_cast<long>(i1.Bool());
                 break;
         case int_type:
-                res = i1->GetInt();
+                res = i1.Int();
                 break;
         case double_type:
-                res = static_cast<long>(i1->GetDouble());
+                res = static_cast<long>(i1.Double());
                 break;
         case string_type:
-                res = atol(i1->GetString());
+                res = atol(i1.String());
                 break;
         }
-        delete operand1;
-        return new RPNValue(res);
+        i1.Set(res);
 }
 
-RPNElem *RPNFunCastDouble::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunCastDouble(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunCastDouble");
-        double res;
-        switch (i1->Type()) {
+        Value& i1 = stack.Top();
+        double res = 0;
+        switch (i1.Type()) {
         case bool_type:
-                res = static_cast<double>(i1->GetBool());
+                res = static_cast<double>(i1.Bool());
                 break;
         case int_type:
-                res = static_cast<double>(i1->GetInt());
+                res = static_cast<double>(i1.Int());
                 break;
         case double_type:
-                res = i1->GetDouble();
+                res = i1.Double();
                 break;
         case string_type:
-                res = atof(i1->GetString());
+                res = atof(i1.String());
                 break;
         }
-        delete operand1;
-        return new RPNValue(res);
+        i1.Set(res);
 }
 
-RPNElem *RPNFunCastString::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunCastString(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunCastString");
+        Value& i1 = stack.Top();
         char res[128];
-        switch (i1->Type()) {
+        switch (i1.Type()) {
         case bool_type:
-                sprintf(res, "%s", i1->GetBool() ? "true" : "false");
+                sprintf(res, "%s", i1.Bool() ? "true" : "false");
                 break;
         case int_type:
-                sprintf(res, "%ld", i1->GetInt());
+                sprintf(res, "%ld", i1.Int());
                 break;
         case double_type:
-                sprintf(res, "%lf", i1->GetDouble());
+                sprintf(res, "%lf", i1.Double());
                 break;
         case string_type:
-                return i1;
+                return;
         }
-        delete operand1;
-        return new RPNValue(res);
+        i1.Set(res);
 }
 
-RPNElem *RPNFunRand::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunRand(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunRand");
-        if (i1->GetInt() < 0)
+        Value& i1 = stack.Top();
+        long range = i1.GetInt();
+        if (range < 0)
                 throw RuntimeError("operand must be > 0", "RPNFunRand");
-        long res = (long)((double)(i1->GetInt() + 1) * rand() / 
-                   (double)RAND_MAX);
-        return new RPNValue(res);
+        long res = (long)((double)(range + 1) * rand() / (double)RAND_MAX);
+        i1.Set(res);
 }
 
-RPNElem *RPNFunAbs::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunAbs(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunAbs");
-        RPNElem *retval;
-        switch (i1->Type()) {
+        Value& i1 = stack.Top();
+        switch (i1.Type()) {
         case int_type:
-                retval = new RPNValue(i1->GetInt() >= 0 ?
-                                      i1->GetInt() : -i1->GetInt());
+                i1.Set(i1.Int() >= 0 ?
+                                      i1.Int() : -i1.Int());
                 break;
         case double_type:
-                retval = new RPNValue(i1->GetDouble() >= 0 ?
-                                      i1->GetDouble() : -i1->GetDouble());
+                i1.Set(i1.Double() >= 0 ?
+                                      i1.Double() : -i1.Double());
                 break;
         default:
                  throw RuntimeError("data type mismatch", "RPNFunAbs");
         }
-        delete operand1;
-        return retval;
 }
 
-RPNElem *RPNFunPow::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunPow(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunPow");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *i2 = dynamic_cast<RPNValue*>(operand2);
-        if (!i2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunPow");
-        double res = pow(i2->GetDouble(), i1->GetInt());
-        delete operand1;
-        delete operand2;
-        return new RPNValue(res);
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        double res = pow(i2.GetDouble(), i1.GetInt());
+        i2.Set(res);
 }
 
-RPNElem *RPNFunSqrt::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunSqrt(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunSqrt");
-        double res = sqrt(i1->GetDouble());
-        delete operand1;
-        return new RPNValue(res);
+        Value& i1 = stack.Top();
+        double res = sqrt(i1.GetDouble());
+        i1.Set(res);
 }
 
-RPNElem *RPNFunSin::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunSin(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunSin");
-        double res = sin(i1->GetDouble());
-        delete operand1;
-        return new RPNValue(res);
+        Value& i1 = stack.Top();
+        double res = sin(i1.GetDouble());
+        i1.Set(res);
 }
 
-RPNElem *RPNFunCos::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunCos(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunCos");
-        double res = cos(i1->GetDouble());
-        delete operand1;
-        return new RPNValue(res);
+        Value& i1 = stack.Top();
+        double res = cos(i1.GetDouble());
+        i1.Set(res);
 }
 
-RPNElem *RPNFunTan::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunTan(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunTan");
-        double res = tan(i1->GetDouble());
-        delete operand1;
-        return new RPNValue(res);
+        Value& i1 = stack.Top();
+        double res = tan(i1.GetDouble());
+        i1.Set(res);
 }
 
-RPNElem *RPNFunAsin::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunAsin(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunAsin");
-        double res = asin(i1->GetDouble());
-        delete operand1;
-        return new RPNValue(res);
+        Value& i1 = stack.Top();
+        double res = asin(i1.GetDouble());
+        i1.Set(res);
 }
 
-RPNElem *RPNFunAcos::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunAcos(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunAcos");
-        double res = acos(i1->GetDouble());
-        delete operand1;
-        return new RPNValue(res);
+        Value& i1 = stack.Top();
+        double res = acos(i1.GetDouble());
+        i1.Set(res);
 }
 
-RPNElem *RPNFunAtan::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunAtan(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunAtan");
-        double res = atan(i1->GetDouble());
-        delete operand1;
-        return new RPNValue(res);
+        Value& i1 = stack.Top();
+        double res = atan(i1.GetDouble());
+        i1.Set(res);
 }
 
-RPNElem *RPNFunAtan2::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunAtan2(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunAtan2");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *i2 = dynamic_cast<RPNValue*>(operand2);
-        if (!i2)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunAtan2");
-        double res = atan2(i2->GetDouble(), i1->GetDouble());
-        delete operand1;
-        delete operand2;
-        return new RPNValue(res);
-}
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        double res = atan2(i2.GetDouble(), i1.GetDouble());
+        i2.Set(res);
+}
+
+static void FunExp(RPNStack& stack)
+{
+        Value& i1 = stack.Top();
+        double res = exp(i1.GetDouble());
+        i1.Set(res);
+}
 
-RPNElem *RPNFunExp::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunLog(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunExp");
-        double res = exp(i1->GetDouble());
-        delete operand1;
-        return new RPNValue(res);
+        Value& i1 = stack.Top();
+        double res = log(i1.GetDouble());
+        i1.Set(res);
 }
 
-RPNElem *RPNFunLog::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunCeil(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunLog");
-        double res = log(i1->GetDouble());
-        delete operand1;
-        return new RPNValue(res);
-}
+        Value& i1 = stack.Top();
+        double res = ceil(i1.GetDouble());
+        i1.Set(res);
+}
 
-RPNElem *RPNFunCeil::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+static void FunFloor(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunCeil");
-        double res = ceil(i1->GetDouble());
-        delete operand1;
-        return new RPNValue(res);
-}
-
-RPNElem *RPNFunFloor::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+        Value& i1 = stack.Top();
+        double res = floor(i1.GetDouble());
+        i1.Set(res);
+}
+
+static void FunTrunc(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunFloor");
-        double res = floor(i1->GetDouble());
-        delete operand1;
-        return new RPNValue(res);
-}
-
-RPNElem *RPNFunTrunc::Call(RPNItem **stack, LabTable& L, VarTable& V) const
+        Value& i1 = stack.Top();
+        double res = trunc(i1.GetDouble());
+        i1.Set(res);
+}
+
+static void FunRound(RPNStack& stack)
 {
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunTrunc");
-        double res = trunc(i1->GetDouble());
-        delete operand1;
-        return new RPNValue(res);
-}
-
-RPNElem *RPNFunRound::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunRound");
-        double res = round(i1->GetDouble());
-        delete operand1;
-        return new RPNValue(res);
-}
-
-RPNElem *RPNFunMax::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunMax");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *i2 = dynamic_cast<RPNValue*>(operand2);
-        if (!i1)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunMax");
-        double res = i2->GetDouble() > i1->GetDouble() ?
-                     i2->GetDouble() : i1->GetDouble();
-        delete operand1;
-        delete operand2;
-        return new RPNValue(res);
+        Value& i1 = stack.Top();
+        double res = round(i1.GetDouble());
+        i1.Set(res);
 }
 
-RPNElem *RPNFunMin::Call(RPNItem **stack, LabTable& L, VarTable& V) const
-{
-        RPNElem *operand1 = Pop(stack);
-        RPNValue *i1 = dynamic_cast<RPNValue*>(operand1);
-        if (!i1)
-                throw RuntimeError("operand1 not RPNValue", "RPNFunMin");
-        RPNElem *operand2 = Pop(stack);
-        RPNValue *i2 = dynamic_cast<RPNValue*>(operand2);
-        if (!i1)
-                throw RuntimeError("operand2 not RPNValue", "RPNFunMin");
-        double res = i2->GetDouble() < i1->GetDouble() ? 
-                     i2->GetDouble() : i1->GetDouble();
-        delete operand1;
-        delete operand2;
-        return new RPNValue(res);
+static void FunMax(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        double x = i2.GetDouble();
+        double y = i1.GetDouble();
+        double res = x > y ? x : y;
+        i2.Set(res);
+}
+
+static void FunMin(RPNStack& stack)
+{
+        const Value& i1 = stack.Pop();
+        Value& i2 = stack.Top();
+        double x = i2.GetDouble();
+        double y = i1.GetDouble();
+        double res = x < y ? x : y;
+        i2.Set(res);
+}
+
+#if defined(THREADED_DISPATCH) && defined(__GNUC__)
+#define HANDLER(op) case op: do_##op
+#define NEXT() \
+        do { \
+                if (pc >= end) \
+                        return; \
+                cmd = &prog[pc++]; \
+                goto *handlers[cmd->op]; \
+        } while (0)
+#else
+#define HANDLER(op) case op
+#define NEXT() break
+#endif
+#if defined(__GNUC__) && __GNUC__ >= 7
+#define FALLTHROUGH() __attribute__((fallthrough))
+#else
+#define FALLTHROUGH() do {} while (0)
+#endif
+#define BRANCH() \
+        do { \
+                if (temps) \
+                        temps->Reset(); \
+                pc = cmd->arg.integer; \
+        } while (0)
+#define SETTLE() \
+        do { \
+                if (temps && stack.Empty()) \
+                        temps->Reset(); \
+        } while (0)
+
+void RPNEngine::Run(RPNProgram& prog, VarTable& V, long pc, long end)
+{
+        RPNInstr *cmd;
+#ifdef ARENA_TEMPORARIES
+        Arena *temps = &arena;
+#else
+        Arena *temps = 0;
+#endif
+#if defined(THREADED_DISPATCH) && defined(__GNUC__)
+        static void *const handlers[] = {
+                &&do_rpn_nop,
+                &&do_rpn_push_bool,
+                &&do_rpn_push_int,
+                &&do_rpn_push_double,
+                &&do_rpn_push_string,
+                &&do_rpn_push_addr,
+                &&do_rpn_jump,
+                &&do_rpn_jump_false,
+                &&do_rpn_alloc,
+                &&do_rpn_free,
+                &&do_rpn_var,
+                &&do_rpn_inc,
+                &&do_rpn_dec,
+                &&do_rpn_assign,
+                &&do_rpn_index,
+                &&do_rpn_plus,
+                &&do_rpn_minus,
+                &&do_rpn_mul,
+                &&do_rpn_div,
+                &&do_rpn_mod,
+                &&do_rpn_uminus,
+                &&do_rpn_eq,
+                &&do_rpn_xor,
+                &&do_rpn_or,
+                &&do_rpn_and,
+                &&do_rpn_not,
+                &&do_rpn_equ,
+                &&do_rpn_neq,
+                &&do_rpn_gtr,
+                &&do_rpn_lss,
+                &&do_rpn_geq,
+                &&do_rpn_leq,
+                &&do_rpn_print,
+                &&do_rpn_scan,
+                &&do_rpn_cast_bool,
+                &&do_rpn_cast_int,
+                &&do_rpn_cast_double,
+                &&do_rpn_cast_string,
+                &&do_rpn_rand,
+                &&do_rpn_abs,
+                &&do_rpn_pow,
+                &&do_rpn_sqrt,
+                &&do_rpn_sin,
+                &&do_rpn_cos,
+                &&do_rpn_tan,
+                &&do_rpn_asin,
+                &&do_rpn_acos,
+                &&do_rpn_atan,
+                &&do_rpn_atan2,
+                &&do_rpn_exp,
+                &&do_rpn_log,
+                &&do_rpn_ceil,
+                &&do_rpn_floor,
+                &&do_rpn_trunc,
+                &&do_rpn_round,
+                &&do_rpn_max,
+                &&do_rpn_min,
+                &&do_rpn_load,
+                &&do_rpn_load_index,
+                &&do_rpn_addr_index,
+                &&do_rpn_store,
+                &&do_rpn_assign_int,
+                &&do_rpn_inc_var,
+                &&do_rpn_dec_var,
+                &&do_rpn_load_plus_int,
+                &&do_rpn_load_minus_int,
+                &&do_rpn_load_mul_int,
+                &&do_rpn_load_div_int,
+                &&do_rpn_load_mod_int,
+                &&do_rpn_equ_jump,
+                &&do_rpn_neq_jump,
+                &&do_rpn_gtr_jump,
+                &&do_rpn_lss_jump,
+                &&do_rpn_geq_jump,
+                &&do_rpn_leq_jump,
+                &&do_rpn_plus_int,
+                &&do_rpn_minus_int,
+                &&do_rpn_mul_int,
+                &&do_rpn_div_int,
+                &&do_rpn_mod_int,
+                &&do_rpn_equ_int,
+                &&do_rpn_neq_int,
+                &&do_rpn_gtr_int,
+                &&do_rpn_lss_int,
+                &&do_rpn_geq_int,
+                &&do_rpn_leq_int,
+                &&do_rpn_equ_jump_int,
+                &&do_rpn_neq_jump_int,
+                &&do_rpn_gtr_jump_int,
+                &&do_rpn_lss_jump_int,
+                &&do_rpn_geq_jump_int,
+                &&do_rpn_leq_jump_int,
+                &&do_rpn_plus_ii,
+                &&do_rpn_minus_ii,
+                &&do_rpn_mul_ii,
+                &&do_rpn_div_ii,
+                &&do_rpn_mod_ii,
+                &&do_rpn_equ_ii,
+                &&do_rpn_neq_ii,
+                &&do_rpn_gtr_ii,
+                &&do_rpn_lss_ii,
+                &&do_rpn_geq_ii,
+                &&do_rpn_leq_ii,
+                &&do_rpn_equ_jump_ii,
+                &&do_rpn_neq_jump_ii,
+                &&do_rpn_gtr_jump_ii,
+                &&do_rpn_lss_jump_ii,
+                &&do_rpn_geq_jump_ii,
+                &&do_rpn_leq_jump_ii,
+                &&do_rpn_plus_store,
+                &&do_rpn_minus_store,
+                &&do_rpn_mul_store,
+                &&do_rpn_div_store,
+                &&do_rpn_mod_store,
+                &&do_rpn_plus_assign,
+                &&do_rpn_minus_assign,
+                &&do_rpn_mul_assign,
+                &&do_rpn_div_assign,
+                &&do_rpn_mod_assign,
+                &&do_rpn_append,
+                &&do_rpn_copy,
+                &&do_rpn_map
+        };
+#endif
+        while (pc < end) {
+                cmd = &prog[pc++];
+                switch (cmd->op) {
+                HANDLER(rpn_nop):
+                        NEXT();
+                HANDLER(rpn_push_bool):
+                        stack.Push().Set(cmd->arg.integer != 0);
+                        NEXT();
+                HANDLER(rpn_push_int):
+                        stack.Push().Set(cmd->arg.integer);
+                        NEXT();
+                HANDLER(rpn_push_double):
+                        stack.Push().Set(cmd->arg.real);
+                        NEXT();
+                HANDLER(rpn_push_string):
+                        stack.Push().Set(cmd->arg.string);
+                        NEXT();
+                HANDLER(rpn_push_addr):
+                        stack.Push().SetAddr(cmd->arg.integer, 0);
+                        NEXT();
+                HANDLER(rpn_jump):
+                        BRANCH();
+                        NEXT();
+                HANDLER(rpn_jump_false):
+                        if (!stack.Pop().GetBool())
+                                BRANCH();
+                        NEXT();
+                HANDLER(rpn_alloc):
+                        FunAlloc(stack, V);
+                        NEXT();
+                HANDLER(rpn_free):
+                        FunFree(stack, V);
+                        NEXT();
+                HANDLER(rpn_var):
+                        FunVar(stack, V);
+                        NEXT();
+                HANDLER(rpn_inc):
+                        FunInc(stack, V);
+                        NEXT();
+                HANDLER(rpn_dec):
+                        FunDec(stack, V);
+                        NEXT();
+                HANDLER(rpn_assign):
+                        FunAssign(stack, V);
+                        SETTLE();
+                        NEXT();
+                HANDLER(rpn_index):
+                        FunIndex(stack);
+                        NEXT();
+                HANDLER(rpn_plus):
+                        Quicken(stack, *cmd, rpn_plus_int);
+                        FunPlus(stack, temps);
+                        NEXT();
+                HANDLER(rpn_minus):
+                        Quicken(stack, *cmd, rpn_minus_int);
+                        FunMinus(stack);
+                        NEXT();
+                HANDLER(rpn_mul):
+                        Quicken(stack, *cmd, rpn_mul_int);
+                        FunMul(stack);
+                        NEXT();
+                HANDLER(rpn_div):
+                        Quicken(stack, *cmd, rpn_div_int);
+                        FunDiv(stack);
+                        NEXT();
+                HANDLER(rpn_mod):
+                        Quicken(stack, *cmd, rpn_mod_int);
+                        FunMod(stack);
+                        NEXT();
+                HANDLER(rpn_uminus):
+                        FunUMinus(stack);
+                        NEXT();
+                HANDLER(rpn_eq):
+                        FunEQ(stack);
+                        NEXT();
+                HANDLER(rpn_xor):
+                        FunXOR(stack);
+                        NEXT();
+                HANDLER(rpn_or):
+                        FunOR(stack);
+                        NEXT();
+                HANDLER(rpn_and):
+                        FunAND(stack);
+                        NEXT();
+                HANDLER(rpn_not):
+                        FunNOT(stack);
+                        NEXT();
+                HANDLER(rpn_equ):
+                        Quicken(stack, *cmd, rpn_equ_int);
+                        FunEQU(stack);
+                        NEXT();
+                HANDLER(rpn_neq):
+                        Quicken(stack, *cmd, rpn_neq_int);
+                        FunNEQ(stack);
+                        NEXT();
+                HANDLER(rpn_gtr):
+                        Quicken(stack, *cmd, rpn_gtr_int);
+                        FunGTR(stack);
+                        NEXT();
+                HANDLER(rpn_lss):
+                        Quicken(stack, *cmd, rpn_lss_int);
+                        FunLSS(stack);
+                        NEXT();
+                HANDLER(rpn_geq):
+                        Quicken(stack, *cmd, rpn_geq_int);
+                        FunGEQ(stack);
+                        NEXT();
+                HANDLER(rpn_leq):
+                        Quicken(stack, *cmd, rpn_leq_int);
+                        FunLEQ(stack);
+                        NEXT();
+                HANDLER(rpn_print):
+                        FunPrint(stack, cmd->arg.integer);
+                        SETTLE();
+                        NEXT();
+                HANDLER(rpn_scan):
+                        FunScan(stack, V);
+                        NEXT();
+                HANDLER(rpn_cast_bool):
+                        FunCastBool(stack);
+                        NEXT();
+                HANDLER(rpn_cast_int):
+                        FunCastInt(stack);
+                        NEXT();
+                HANDLER(rpn_cast_double):
+                        FunCastDouble(stack);
+                        NEXT();
+                HANDLER(rpn_cast_string):
+                        FunCastString(stack);
+                        NEXT();
+                HANDLER(rpn_rand):
+                        FunRand(stack);
+                        NEXT();
+                HANDLER(rpn_abs):
+                        FunAbs(stack);
+                        NEXT();
+                HANDLER(rpn_pow):
+                        FunPow(stack);
+                        NEXT();
+                HANDLER(rpn_sqrt):
+                        FunSqrt(stack);
+                        NEXT();
+                HANDLER(rpn_sin):
+                        FunSin(stack);
+                        NEXT();
+                HANDLER(rpn_cos):
+                        FunCos(stack);
+                        NEXT();
+                HANDLER(rpn_tan):
+                        FunTan(stack);
+                        NEXT();
+                HANDLER(rpn_asin):
+                        FunAsin(stack);
+                        NEXT();
+                HANDLER(rpn_acos):
+                        FunAcos(stack);
+                        NEXT();
+                HANDLER(rpn_atan):
+                        FunAtan(stack);
+                        NEXT();
+                HANDLER(rpn_atan2):
+                        FunAtan2(stack);
+                        NEXT();
+                HANDLER(rpn_exp):
+                        FunExp(stack);
+                        NEXT();
+                HANDLER(rpn_log):
+                        FunLog(stack);
+                        NEXT();
+                HANDLER(rpn_ceil):
+                        FunCeil(stack);
+                        NEXT();
+                HANDLER(rpn_floor):
+                        FunFloor(stack);
+                        NEXT();
+                HANDLER(rpn_trunc):
+                        FunTrunc(stack);
+                        NEXT();
+                HANDLER(rpn_round):
+                        FunRound(stack);
+                        NEXT();
+                HANDLER(rpn_max):
+                        FunMax(stack);
+                        NEXT();
+                HANDLER(rpn_min):
+                        FunMin(stack);
+                        NEXT();
+                HANDLER(rpn_load):
+                        FunLoad(stack, V, cmd->slot);
+                        NEXT();
+                HANDLER(rpn_load_index):
+                        FunLoadIndex(stack, V, cmd->slot);
+                        NEXT();
+                HANDLER(rpn_addr_index):
+                        FunAddrIndex(stack, cmd->slot);
+                        NEXT();
+                HANDLER(rpn_store):
+                        FunStore(stack, V, cmd->slot);
+                        SETTLE();
+                        NEXT();
+                HANDLER(rpn_assign_int):
+                        FunAssignInt(V, cmd->slot, cmd->arg.integer);
+                        NEXT();
+                HANDLER(rpn_inc_var):
+                        Step(V, cmd->slot, 0, 1);
+                        NEXT();
+                HANDLER(rpn_dec_var):
+                        Step(V, cmd->slot, 0, -1);
+                        NEXT();
+                HANDLER(rpn_load_plus_int):
+                        FunLoadPlusInt(stack, V, *cmd);
+                        NEXT();
+                HANDLER(rpn_load_minus_int):
+                        FunLoadMinusInt(stack, V, *cmd);
+                        NEXT();
+                HANDLER(rpn_load_mul_int):
+                        FunLoadMulInt(stack, V, *cmd);
+                        NEXT();
+                HANDLER(rpn_load_div_int):
+                        FunLoadDivInt(stack, V, *cmd);
+                        NEXT();
+                HANDLER(rpn_load_mod_int):
+                        FunLoadModInt(stack, V, *cmd);
+                        NEXT();
+                HANDLER(rpn_equ_jump):
+                        Quicken(stack, *cmd, rpn_equ_jump_int);
+                        if (FunEQUJump(stack))
+                                BRANCH();
+                        NEXT();
+                HANDLER(rpn_neq_jump):
+                        Quicken(stack, *cmd, rpn_neq_jump_int);
+                        if (FunNEQJump(stack))
+                                BRANCH();
+                        NEXT();
+                HANDLER(rpn_gtr_jump):
+                        Quicken(stack, *cmd, rpn_gtr_jump_int);
+                        if (FunGTRJump(stack))
+                                BRANCH();
+                        NEXT();
+                HANDLER(rpn_lss_jump):
+                        Quicken(stack, *cmd, rpn_lss_jump_int);
+                        if (FunLSSJump(stack))
+                                BRANCH();
+                        NEXT();
+                HANDLER(rpn_geq_jump):
+                        Quicken(stack, *cmd, rpn_geq_jump_int);
+                        if (FunGEQJump(stack))
+                                BRANCH();
+                        NEXT();
+                HANDLER(rpn_leq_jump):
+                        Quicken(stack, *cmd, rpn_leq_jump_int);
+                        if (FunLEQJump(stack))
+                                BRANCH();
+                        NEXT();
+                HANDLER(rpn_plus_int):
+                        if (!Guard(stack, *cmd, rpn_plus)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_plus_ii):
+                        FunPlusII(stack);
+                        NEXT();
+                HANDLER(rpn_minus_int):
+                        if (!Guard(stack, *cmd, rpn_minus)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_minus_ii):
+                        FunMinusII(stack);
+                        NEXT();
+                HANDLER(rpn_mul_int):
+                        if (!Guard(stack, *cmd, rpn_mul)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_mul_ii):
+                        FunMulII(stack);
+                        NEXT();
+                HANDLER(rpn_div_int):
+                        if (!Guard(stack, *cmd, rpn_div)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_div_ii):
+                        FunDivII(stack);
+                        NEXT();
+                HANDLER(rpn_mod_int):
+                        if (!Guard(stack, *cmd, rpn_mod)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_mod_ii):
+                        FunModII(stack);
+                        NEXT();
+                HANDLER(rpn_equ_int):
+                        if (!Guard(stack, *cmd, rpn_equ)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_equ_ii):
+                        FunEQUII(stack);
+                        NEXT();
+                HANDLER(rpn_neq_int):
+                        if (!Guard(stack, *cmd, rpn_neq)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_neq_ii):
+                        FunNEQII(stack);
+                        NEXT();
+                HANDLER(rpn_gtr_int):
+                        if (!Guard(stack, *cmd, rpn_gtr)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_gtr_ii):
+                        FunGTRII(stack);
+                        NEXT();
+                HANDLER(rpn_lss_int):
+                        if (!Guard(stack, *cmd, rpn_lss)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_lss_ii):
+                        FunLSSII(stack);
+                        NEXT();
+                HANDLER(rpn_geq_int):
+                        if (!Guard(stack, *cmd, rpn_geq)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_geq_ii):
+                        FunGEQII(stack);
+                        NEXT();
+                HANDLER(rpn_leq_int):
+                        if (!Guard(stack, *cmd, rpn_leq)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_leq_ii):
+                        FunLEQII(stack);
+                        NEXT();
+                HANDLER(rpn_equ_jump_int):
+                        if (!Guard(stack, *cmd, rpn_equ_jump)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_equ_jump_ii):
+                        if (FunEQUJumpII(stack))
+                                BRANCH();
+                        NEXT();
+                HANDLER(rpn_neq_jump_int):
+                        if (!Guard(stack, *cmd, rpn_neq_jump)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_neq_jump_ii):
+                        if (FunNEQJumpII(stack))
+                                BRANCH();
+                        NEXT();
+                HANDLER(rpn_gtr_jump_int):
+                        if (!Guard(stack, *cmd, rpn_gtr_jump)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_gtr_jump_ii):
+                        if (FunGTRJumpII(stack))
+                                BRANCH();
+                        NEXT();
+                HANDLER(rpn_lss_jump_int):
+                        if (!Guard(stack, *cmd, rpn_lss_jump)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_lss_jump_ii):
+                        if (FunLSSJumpII(stack))
+                                BRANCH();
+                        NEXT();
+                HANDLER(rpn_geq_jump_int):
+                        if (!Guard(stack, *cmd, rpn_geq_jump)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_geq_jump_ii):
+                        if (FunGEQJumpII(stack))
+                                BRANCH();
+                        NEXT();
+                HANDLER(rpn_leq_jump_int):
+                        if (!Guard(stack, *cmd, rpn_leq_jump)) {
+                                pc--;
+                                NEXT();
+                        }
+                        FALLTHROUGH();
+                HANDLER(rpn_leq_jump_ii):
+                        if (FunLEQJumpII(stack))
+                                BRANCH();
+                        NEXT();
+                HANDLER(rpn_plus_store):
+                        FunUpdateVar(stack, V, cmd->slot, AddTo);
+                        SETTLE();
+                        NEXT();
+                HANDLER(rpn_minus_store):
+                        FunUpdateVar(stack, V, cmd->slot, Sub);
+                        NEXT();
+                HANDLER(rpn_mul_store):
+                        FunUpdateVar(stack, V, cmd->slot, Mul);
+                        NEXT();
+                HANDLER(rpn_div_store):
+                        FunUpdateVar(stack, V, cmd->slot, Div);
+                        NEXT();
+                HANDLER(rpn_mod_store):
+                        FunUpdateVar(stack, V, cmd->slot, Mod);
+                        NEXT();
+                HANDLER(rpn_plus_assign):
+                        FunUpdate(stack, V, AddTo);
+                        SETTLE();
+                        NEXT();
+                HANDLER(rpn_minus_assign):
+                        FunUpdate(stack, V, Sub);
+                        NEXT();
+                HANDLER(rpn_mul_assign):
+                        FunUpdate(stack, V, Mul);
+                        NEXT();
+                HANDLER(rpn_div_assign):
+                        FunUpdate(stack, V, Div);
+                        NEXT();
+                HANDLER(rpn_mod_assign):
+                        FunUpdate(stack, V, Mod);
+                        NEXT();
+                HANDLER(rpn_append):
+                        FunAppend(stack, V);
+                        SETTLE();
+                        NEXT();
+                HANDLER(rpn_copy):
+                        FunCopy(stack, V);
+                        NEXT();
+                HANDLER(rpn_map):
+                        FunMap(stack, V, cmd->arg.integer);
+                        NEXT();
+                }
+        }
 }
 
+#undef HANDLER
+#undef NEXT
+#undef BRANCH
+#undef SETTLE
+#undef FALLTHROUGH
@@ -2,478 +2,216 @@
 #define ENGINE_HPP_SENTRY
 
 #include "vartable.hpp"
-#include "labtable.hpp"
+#include "strpool.hpp"
+#include "arena.hpp"
 #include "common.hpp"
 #include "error.hpp"
 
-struct RPNItem {
-        class RPNElem *elem;
-        RPNItem *next;
-};
-
-class RPNElem {
-public:
-        virtual ~RPNElem() {}
-        virtual void Evaluate(RPNItem **cur_cmd, RPNItem **stack,
-                              LabTable& L, VarTable& V) const = 0;
-protected:
-        static void Push(RPNItem **stack, RPNElem *unit);
-        static RPNElem *Pop(RPNItem **stack);
-};
-
-class RPNJump : public RPNElem {
-public:
-        RPNJump() {}
-        virtual ~RPNJump() {}
-        virtual void Evaluate(RPNItem **cur_cmd, RPNItem **stack,
-                              LabTable& L, VarTable& V) const;
-};
-
-class RPNJumpFalse : public RPNElem {
-public:
-        RPNJumpFalse() {}
-        virtual ~RPNJumpFalse() {}
-        virtual void Evaluate(RPNItem **cur_cmd, RPNItem **stack,
-                              LabTable& L, VarTable& V) const;
-};
-
-class RPNConst : public RPNElem {
-public:
-        virtual ~RPNConst() {}
-        virtual void Evaluate(RPNItem **cur_cmd, RPNItem **stack,
-                              LabTable& L, VarTable& V) const;
-        virtual RPNElem *Clone() const = 0;
-};
-
-class RPNAddr : public RPNConst {
+enum RPNOpCode {
+        rpn_nop,
+        rpn_push_bool,
+        rpn_push_int,
+        rpn_push_double,
+        rpn_push_string,
+        rpn_push_addr,
+        rpn_jump,
+        rpn_jump_false,
+        rpn_alloc,
+        rpn_free,
+        rpn_var,
+        rpn_inc,
+        rpn_dec,
+        rpn_assign,
+        rpn_index,
+        rpn_plus,
+        rpn_minus,
+        rpn_mul,
+        rpn_div,
+        rpn_mod,
+        rpn_uminus,
+        rpn_eq,
+        rpn_xor,
+        rpn_or,
+        rpn_and,
+        rpn_not,
+        rpn_equ,
+        rpn_neq,
+        rpn_gtr,
+        rpn_lss,
+        rpn_geq,
+        rpn_leq,
+        rpn_print,
+        rpn_scan,
+        rpn_cast_bool,
+        rpn_cast_int,
+        rpn_cast_double,
+        rpn_cast_string,
+        rpn_rand,
+        rpn_abs,
+        rpn_pow,
+        rpn_sqrt,
+        rpn_sin,
+        rpn_cos,
+        rpn_tan,
+        rpn_asin,
+        rpn_acos,
+        rpn_atan,
+        rpn_atan2,
+        rpn_exp,
+        rpn_log,
+        rpn_ceil,
+        rpn_floor,
+        rpn_trunc,
+        rpn_round,
+        rpn_max,
+        rpn_min,
+        rpn_load,
+        rpn_load_index,
+        rpn_addr_index,
+        rpn_store,
+        rpn_assign_int,
+        rpn_inc_var,
+        rpn_dec_var,
+        rpn_load_plus_int,
+        rpn_load_minus_int,
+        rpn_load_mul_int,
+        rpn_load_div_int,
+        rpn_load_mod_int,
+        rpn_equ_jump,
+        rpn_neq_jump,
+        rpn_gtr_jump,
+        rpn_lss_jump,
+        rpn_geq_jump,
+        rpn_leq_jump,
+        rpn_plus_int,
+        rpn_minus_int,
+        rpn_mul_int,
+        rpn_div_int,
+        rpn_mod_int,
+        rpn_equ_int,
+        rpn_neq_int,
+        rpn_gtr_int,
+        rpn_lss_int,
+        rpn_geq_int,
+        rpn_leq_int,
+        rpn_equ_jump_int,
+        rpn_neq_jump_int,
+        rpn_gtr_jump_int,
+        rpn_lss_jump_int,
+        rpn_geq_jump_int,
+        rpn_leq_jump_int,
+        rpn_plus_ii,
+        rpn_minus_ii,
+        rpn_mul_ii,
+        rpn_div_ii,
+        rpn_mod_ii,
+        rpn_equ_ii,
+        rpn_neq_ii,
+        rpn_gtr_ii,
+        rpn_lss_ii,
+        rpn_geq_ii,
+        rpn_leq_ii,
+        rpn_equ_jump_ii,
+        rpn_neq_jump_ii,
+        rpn_gtr_jump_ii,
+        rpn_lss_jump_ii,
+        rpn_geq_jump_ii,
+        rpn_leq_jump_ii,
+        rpn_plus_store,
+        rpn_minus_store,
+        rpn_mul_store,
+        rpn_div_store,
+        rpn_mod_store,
+        rpn_plus_assign,
+        rpn_minus_assign,
+        rpn_mul_assign,
+        rpn_div_assign,
+        rpn_mod_assign,
+        rpn_append,
+        rpn_copy,
+        rpn_map
+};
+
+struct RPNOpInfo {
         const char *name;
-        long index;
-public:
-        RPNAddr(const char *str, long num = 0) { name = dupstr(str); index = num; }
-        virtual ~RPNAddr() { delete []name; }
-        virtual RPNElem *Clone() const { return new RPNAddr(name, index); }
-        const char *Name() const { return name; }
-        long Index() const { return index; }
+        const char *pops;
+        const char *pushes;
 };
 
-class RPNLabel : public RPNConst {
-        RPNItem *value;
-public:
-        RPNLabel(RPNItem *val) { value = val; }
-        virtual ~RPNLabel() {}
-        virtual RPNElem *Clone() const { return new RPNLabel(value); }
-        RPNItem *Get() const { return value; }
-};
-
-class RPNValue : public RPNConst {
-        DataType type;
+struct RPNInstr {
+        RPNOpCode op;
+        unsigned int line;
+        long slot;
         union {
-                bool boolean;
                 long integer;
                 double real;
-                char *string;
-        } value;
-public:
-        RPNValue(bool val) : type(bool_type) { value.boolean = val; }
-        RPNValue(long val) : type(int_type) { value.integer = val; }
-        RPNValue(double val) : type(double_type) { value.real = val; }
-        RPNValue(const char *val) : type(string_type)
-                { value.string = dupstr(val); }
-        RPNValue(const RPNValue &RPNVal) : type(RPNVal.type) {
-                if (type != string_type)
-                        value = RPNVal.value;
-                else
-                        value.string = dupstr(RPNVal.value.string);
-        }
-        virtual ~RPNValue() { if (type == string_type) delete []value.string; }
-        virtual RPNElem *Clone() const { return new RPNValue(*this); }
-        DataType Type() const { return type; }
-        bool GetBool() const {
-                if (type != bool_type)
-                        throw RuntimeError("RPNValue", "data type mismatch");
-                return value.boolean;
-        }
-        long GetInt() const {
-                if (type != int_type)
-                        throw RuntimeError("RPNValue", "data type mismatch");
-                return value.integer; 
-        }
-        double GetDouble() const {
-                if (type != double_type)
-                        throw RuntimeError("RPNValue", "data type mismatch");
-                return value.real;
-        }
-        const char *GetString() const {
-                if (type != string_type)
-                        throw RuntimeError("RPNValue", "data type mismatch");
-                return value.string;
-        }
-};
-
-class RPNFunction : public RPNElem {
-public:
-        virtual ~RPNFunction() {}
-        virtual void Evaluate(RPNItem **cur_cmd, RPNItem **stack,
-                              LabTable& L, VarTable& V) const;
-        virtual RPNElem *Call(RPNItem **stack,
-                              LabTable& L, VarTable& V) const = 0;
-};
-
-class RPNFunNull : public RPNFunction {
-public:
-        RPNFunNull() {}
-        virtual ~RPNFunNull() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunAlloc : public RPNFunction {
-public:
-        RPNFunAlloc() {}
-        virtual ~RPNFunAlloc() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunFree : public RPNFunction {
-public:
-        RPNFunFree() {}
-        virtual ~RPNFunFree() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunLab : public RPNFunction {
-public:
-        RPNFunLab() {}
-        virtual ~RPNFunLab() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunVar : public RPNFunction {
-public:
-        RPNFunVar() {}
-        virtual ~RPNFunVar() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunInc : public RPNFunction {
-public:
-        RPNFunInc() {}
-        virtual ~RPNFunInc() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunDec : public RPNFunction {
-public:
-        RPNFunDec() {}
-        virtual ~RPNFunDec() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunAssign : public RPNFunction {
-public:
-        RPNFunAssign() {}
-        virtual ~RPNFunAssign() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunIndex : public RPNFunction {
-public:
-        RPNFunIndex() {}
-        virtual ~RPNFunIndex() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunPlus : public RPNFunction {
-public:
-        RPNFunPlus() {}
-        virtual ~RPNFunPlus() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunMinus : public RPNFunction {
-public:
-        RPNFunMinus() {}
-        virtual ~RPNFunMinus() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunMul : public RPNFunction {
-public:
-        RPNFunMul() {}
-        virtual ~RPNFunMul() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunDiv : public RPNFunction {
-public:
-        RPNFunDiv() {}
-        virtual ~RPNFunDiv() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunMod : public RPNFunction {
-public:
-        RPNFunMod() {}
-        virtual ~RPNFunMod() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunUMinus : public RPNFunction {
-public:
-        RPNFunUMinus() {}
-        virtual ~RPNFunUMinus() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunEQ : public RPNFunction {
-public:
-        RPNFunEQ() {}
-        virtual ~RPNFunEQ() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunXOR : public RPNFunction {
-public:
-        RPNFunXOR() {}
-        virtual ~RPNFunXOR() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunOR : public RPNFunction {
-public:
-        RPNFunOR() {}
-        virtual ~RPNFunOR() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunAND : public RPNFunction {
-public:
-        RPNFunAND() {}
-        virtual ~RPNFunAND() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunNOT : public RPNFunction {
-public:
-        RPNFunNOT() {}
-        virtual ~RPNFunNOT() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunEQU : public RPNFunction {
-public:
-        RPNFunEQU() {}
-        virtual ~RPNFunEQU() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunNEQ : public RPNFunction {
-public:
-        RPNFunNEQ() {}
-        virtual ~RPNFunNEQ() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunGTR : public RPNFunction {
-public:
-        RPNFunGTR() {}
-        virtual ~RPNFunGTR() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunLSS : public RPNFunction {
-public:
-        RPNFunLSS() {}
-        virtual ~RPNFunLSS() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunGEQ : public RPNFunction {
-public:
-        RPNFunGEQ() {}
-        virtual ~RPNFunGEQ() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunLEQ : public RPNFunction {
-public:
-        RPNFunLEQ() {}
-        virtual ~RPNFunLEQ() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunPrint : public RPNFunction {
-public:
-        RPNFunPrint() {}
-        virtual ~RPNFunPrint() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunScan : public RPNFunction {
-public:
-        RPNFunScan() {}
-        virtual ~RPNFunScan() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunCastBool : public RPNFunction {
-public:
-        RPNFunCastBool() {}
-        virtual ~RPNFunCastBool() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunCastInt : public RPNFunction {
-public:
-        RPNFunCastInt() {}
-        virtual ~RPNFunCastInt() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunCastDouble : public RPNFunction {
-public:
-        RPNFunCastDouble() {}
-        virtual ~RPNFunCastDouble() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunCastString : public RPNFunction {
-public:
-        RPNFunCastString() {}
-        virtual ~RPNFunCastString() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunRand : public RPNFunction {
-public:
-        RPNFunRand() {}
-        virtual ~RPNFunRand() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunAbs : public RPNFunction {
-public:
-        RPNFunAbs() {}
-        virtual ~RPNFunAbs() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunPow : public RPNFunction {
-public:
-        RPNFunPow() {}
-        virtual ~RPNFunPow() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunSqrt : public RPNFunction {
-public:
-        RPNFunSqrt() {}
-        virtual ~RPNFunSqrt() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunSin : public RPNFunction {
-public:
-        RPNFunSin() {}
-        virtual ~RPNFunSin() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunCos : public RPNFunction {
-public:
-        RPNFunCos() {}
-        virtual ~RPNFunCos() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunTan : public RPNFunction {
-public:
-        RPNFunTan() {}
-        virtual ~RPNFunTan() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunAsin : public RPNFunction {
-public:
-        RPNFunAsin() {}
-        virtual ~RPNFunAsin() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunAcos : public RPNFunction {
-public:
-        RPNFunAcos() {}
-        virtual ~RPNFunAcos() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunAtan : public RPNFunction {
-public:
-        RPNFunAtan() {}
-        virtual ~RPNFunAtan() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunAtan2 : public RPNFunction {
-public:
-        RPNFunAtan2() {}
-        virtual ~RPNFunAtan2() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunExp : public RPNFunction {
-public:
-        RPNFunExp() {}
-        virtual ~RPNFunExp() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunLog : public RPNFunction {
-public:
-        RPNFunLog() {}
-        virtual ~RPNFunLog() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunCeil : public RPNFunction {
-public:
-        RPNFunCeil() {}
-        virtual ~RPNFunCeil() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunFloor : public RPNFunction {
-public:
-        RPNFunFloor() {}
-        virtual ~RPNFunFloor() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunTrunc : public RPNFunction {
-public:
-        RPNFunTrunc() {}
-        virtual ~RPNFunTrunc() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunRound : public RPNFunction {
-public:
-        RPNFunRound() {}
-        virtual ~RPNFunRound() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunMax : public RPNFunction {
-public:
-        RPNFunMax() {}
-        virtual ~RPNFunMax() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
-};
-
-class RPNFunMin : public RPNFunction {
-public:
-        RPNFunMin() {}
-        virtual ~RPNFunMin() {}
-        virtual RPNElem *Call(RPNItem **stack, LabTable& L, VarTable& V) const;
+                StringData *string;
+        } arg;
+};
+
+class RPNProgram {
+        RPNInstr *code;
+        long size;
+        long allocated;
+        long depth;
+        unsigned int line;
+        StringPool strings;
+        static const RPNOpInfo info[];
+public:
+        RPNProgram();
+        ~RPNProgram();
+        long Emit(RPNOpCode op, long arg = 0);
+        long EmitReal(RPNOpCode op, double arg);
+        long EmitString(RPNOpCode op, const char *arg);
+        void SetLine(unsigned int num) { line = num; }
+        void SetTarget(long idx, long target)
+                { code[idx].arg.integer = target; }
+        void SetConstant(long idx, const Value& val);
+        void Remove(long idx);
+        void Verify();
+        void Compact();
+        long Size() const { return size; }
+        long StackDepth() const { return depth; }
+        long Pops(long idx) const;
+        long Pushes(long idx) const;
+        const RPNInstr& operator[](long idx) const { return code[idx]; }
+        RPNInstr& operator[](long idx) { return code[idx]; }
+        static bool IsJump(RPNOpCode op);
+        static bool IsConstant(RPNOpCode op);
+        static const char *Name(RPNOpCode op) { return info[op].name; }
+        static int OpCount();
+private:
+        RPNProgram(const RPNProgram&);
+        void operator=(const RPNProgram&);
+        long Append(RPNOpCode op);
+};
+
+class RPNStack {
+        Value *data;
+        long sp;
+public:
+        RPNStack(long capacity);
+        ~RPNStack() { delete[] data; }
+        Value& Push() { return data[sp++]; }
+        Value& Pop() { return data[--sp]; }
+        Value *Pop(long count) { sp -= count; return data + sp; }
+        Value& Top() { return data[sp - 1]; }
+        bool Empty() const { return sp == 0; }
+        Value& Peek(long depth) { return data[sp - 1 - depth]; }
+private:
+        RPNStack(const RPNStack&);
+        void operator=(const RPNStack&);
+};
+
+class RPNEngine {
+        RPNStack stack;
+        Arena arena;
+public:
+        RPNEngine(const RPNProgram& prog) : stack(prog.StackDepth()) {}
+        void Run(RPNProgram& prog, VarTable& V)
+                { Run(prog, V, 0, prog.Size()); }
+        void Run(RPNProgram& prog, VarTable& V, long pc, long end);
+        const Value& Result() { return stack.Top(); }
 };
 
 #endif
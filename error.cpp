@@ -9,10 +9,15 @@ void Error::Report() const
 
 void SyntaxError::Report() const
 {
-        if (lex) {
+        if (lex)
                 fprintf(stderr, "token: %s\n", lex->token);
-                fprintf(stderr, "line: %i\n", lex->line);
-        }
+        if (Line())
+                fprintf(stderr, "line: %i\n", Line());
         Error::Report();
 }
 
+unsigned int SyntaxError::Line() const
+{
+        return lex ? lex->line : line;
+}
+
@@ -17,12 +17,16 @@ public:
 
 class SyntaxError : public Error {
         class LexItem *lex;
+        unsigned int line;
 public:
         SyntaxError(const char *msg, LexItem *ptr) : Error("error", msg)
-                { lex = ptr; }
+                { lex = ptr; line = 0; }
+        SyntaxError(const char *msg, unsigned int num) : Error("error", msg)
+                { lex = 0; line = num; }
         ~SyntaxError() {}
         void Report() const;
         LexItem *Token() const { return lex; }
+        unsigned int Line() const;
 };
 
 class RuntimeError : public Error {
@@ -2,36 +2,36 @@
 #define HASHTABLE_HPP_SENTRY
 
 #include <cstring>
-#include "common.hpp"
 #include "error.hpp"
 
 template <class T>
 class HashTable {
-        struct Node {
+        struct Slot {
                 T data;
-                const char *key;
-                bool is_deleted;
-                Node(const T& val, const char *str)
-                        : data(val), key(dupstr(str)), is_deleted(false) {}
-                ~Node() { delete[] key; }
+                char *key;
+                unsigned int hash;
+                int distance;
         };
-        Node **array;
+        Slot *array;
         int array_size;
-        int array_used;
-        int not_deleted;
+        int count;
         static const int initial_size;
         static const double rehash_size;
 public:
         HashTable();
         ~HashTable();
         bool Add(const T& data, const char *key);
+        T& FindOrAdd(const T& data, const char *key, bool& added);
         bool Remove(const char *key);
         bool Find(const char *key) const;
         T& operator[](const char *key) const;
 private:
+        HashTable(const HashTable&);
+        void operator=(const HashTable&);
+        int Locate(const char *key, unsigned int hash) const;
+        int Place(Slot entry);
         void Resize();
-        void Rehash();
-        static int Hash(const char *key, int size, int k);
+        static unsigned int Hash(const char *key);
 };
 
 template <class T>
@@ -44,19 +44,18 @@ template <class T>
 HashTable<T>::HashTable()
 {
         array_size = initial_size;
-        array_used = 0;
-        not_deleted = 0;
-        array = new Node*[initial_size];
+        count = 0;
+        array = new Slot[array_size];
         for (int i = 0; i < array_size; i++)
-                array[i] = 0;
+                array[i].distance = 0;
 }
 
 template <class T>
 HashTable<T>::~HashTable()
 {
         for (int i = 0; i < array_size; i++) {
-                if (array[i])
-                        delete array[i];
+                if (array[i].distance)
+                        delete[] array[i].key;
         }
         delete[] array;
 }
@@ -64,129 +63,129 @@ HashTable<T>::~HashTable()
 template <class T>
 bool HashTable<T>::Add(const T& data, const char *key)
 {
-        if (not_deleted + 1 > int(rehash_size * array_size))
+        bool added;
+        FindOrAdd(data, key, added);
+        return added;
+}
+
+template <class T>
+T& HashTable<T>::FindOrAdd(const T& data, const char *key, bool& added)
+{
+        unsigned int hash = Hash(key);
+        int idx = Locate(key, hash);
+        added = idx < 0;
+        if (!added)
+                return array[idx].data;
+        if (count + 1 > int(rehash_size * array_size))
                 Resize();
-        else if (array_used > 2 * not_deleted)
-                Rehash();
-        int h1 = Hash(key, array_size, array_size - 1);
-        int h2 = Hash(key, array_size, array_size + 1);
-        int first_deleted = -1;
-        for (int i = 0; i < array_size && array[h1]; i++) {
-                if (!strcmp(array[h1]->key, key) && !array[h1]->is_deleted)
-                        return false;
-                if (array[h1]->is_deleted && first_deleted == -1)
-                        first_deleted = h1;
-                h1 = (h1 + h2) % array_size;
-        }
-        if (first_deleted == -1) {
-                array[h1] = new Node(data, key);
-                array_used++;
-        } else {
-                delete array[first_deleted];
-                array[first_deleted] = new Node(data, key);
-        }
-        not_deleted++;
-        return true;
+        size_t len = strlen(key) + 1;
+        Slot entry;
+        entry.data = data;
+        entry.key = new char[len];
+        memcpy(entry.key, key, len);
+        entry.hash = hash;
+        count++;
+        return array[Place(entry)].data;
 }
 
 template <class T>
 bool HashTable<T>::Remove(const char *key)
 {
-        int h1 = Hash(key, array_size, array_size - 1);
-        int h2 = Hash(key, array_size, array_size + 1);
-        for (int i = 0; i < array_size && array[h1]; i++) {
-                if (!strcmp(array[h1]->key, key)) {
-                        if (array[h1]->is_deleted)
-                                return false;
-                        array[h1]->is_deleted = true;
-                        not_deleted--;
-                        return true;
-                }
-                h1 = (h1 + h2) % array_size;
+        int idx = Locate(key, Hash(key));
+        if (idx < 0)
+                return false;
+        delete[] array[idx].key;
+        int mask = array_size - 1;
+        int next = (idx + 1) & mask;
+        while (array[next].distance > 1) {
+                array[idx] = array[next];
+                array[idx].distance--;
+                idx = next;
+                next = (next + 1) & mask;
         }
-        return false;
+        array[idx].distance = 0;
+        count--;
+        return true;
 }
 
 template <class T>
 bool HashTable<T>::Find(const char *key) const
 {
-        int h1 = Hash(key, array_size, array_size - 1);
-        int h2 = Hash(key, array_size, array_size + 1);
-        for (int i = 0; i < array_size && array[h1]; i++) {
-                if (!strcmp(array[h1]->key, key) && !array[h1]->is_deleted)
-                        return true;
-                h1 = (h1 + h2) % array_size;
-        }
-        return false;
+        return Locate(key, Hash(key)) >= 0;
 }
 
 template <class T>
 T& HashTable<T>::operator[](const char *key) const
 {
-        int h1 = Hash(key, array_size, array_size - 1);
-        int h2 = Hash(key, array_size, array_size + 1);
-        for (int i = 0; i < array_size && array[h1]; i++) {
-                if (!strcmp(array[h1]->key, key) && !array[h1]->is_deleted)
-                        return array[h1]->data;
-                h1 = (h1 + h2) % array_size;
-        }
-        throw RuntimeError("not found in table", key);
+        int idx = Locate(key, Hash(key));
+        if (idx < 0)
+                throw RuntimeError("not found in table", key);
+        return array[idx].data;
 }
 
 template <class T>
-void HashTable<T>::Resize()
+int HashTable<T>::Locate(const char *key, unsigned int hash) const
 {
-        int old_array_size = array_size;
-        array_size <<= 1;
-        array_used = 0;
-        not_deleted = 0;
-        Node **array2 = new Node*[array_size];
-        for (int i = 0; i < array_size; ++i)
-                array2[i] = 0;
-        Node **tmp = array;
-        array = array2;
-        array2 = tmp;
-        for (int i = 0; i < old_array_size; i++) {
-                if (array2[i] && !array2[i]->is_deleted)
-                        Add(array2[i]->data, array2[i]->key);
-        }
-        for (int i = 0; i < old_array_size; i++) {
-                if (array2[i])
-                        delete array2[i];
+        int mask = array_size - 1;
+        int idx = hash & mask;
+        for (int dist = 1; array[idx].distance >= dist; dist++) {
+                const Slot& cur = array[idx];
+                if (cur.hash == hash && !strcmp(cur.key, key))
+                        return idx;
+                idx = (idx + 1) & mask;
         }
-        delete[] array2;
+        return -1;
 }
 
 template <class T>
-void HashTable<T>::Rehash()
+int HashTable<T>::Place(Slot entry)
 {
-        array_used = 0;
-        not_deleted = 0;
-        Node **array2 = new Node*[array_size];
-        for (int i = 0; i < array_size; ++i)
-                array2[i] = 0;
-        Node **tmp = array;
-        array = array2;
-        array2 = tmp;
-        for (int i = 0; i < array_size; i++) {
-                if (array2[i] && !array2[i]->is_deleted)
-                        Add(array2[i]->data, array2[i]->key);
-        }
-        for (int i = 0; i < array_size; i++) {
-                if (array2[i])
-                        delete array2[i];
+        int mask = array_size - 1;
+        int idx = entry.hash & mask;
+        int res = -1;
+        entry.distance = 1;
+        for (;;) {
+                Slot& cur = array[idx];
+                if (!cur.distance) {
+                        cur = entry;
+                        return res < 0 ? idx : res;
+                }
+                if (cur.distance < entry.distance) {
+                        Slot tmp = cur;
+                        cur = entry;
+                        entry = tmp;
+                        if (res < 0)
+                                res = idx;
+                }
+                idx = (idx + 1) & mask;
+                entry.distance++;
         }
-        delete[] array2;
+}
 
+template <class T>
+void HashTable<T>::Resize()
+{
+        Slot *old = array;
+        int old_size = array_size;
+        array_size <<= 1;
+        array = new Slot[array_size];
+        for (int i = 0; i < array_size; i++)
+                array[i].distance = 0;
+        for (int i = 0; i < old_size; i++) {
+                if (old[i].distance)
+                        Place(old[i]);
+        }
+        delete[] old;
 }
 
 template <class T>
-int HashTable<T>::Hash(const char *key, int size, int k)
+unsigned int HashTable<T>::Hash(const char *key)
 {
-        int hash = 0;
-        for (int i = 0; key[i]; i++)
-                hash = (hash * k + key[i]) % size;
-        hash = (hash * 2 + 1) % size;
+        unsigned int hash = 2166136261U;
+        for (int i = 0; key[i]; i++) {
+                hash ^= (unsigned char)key[i];
+                hash *= 16777619U;
+        }
         return hash;
 }
 
@@ -7,6 +7,8 @@
 #include "vartable.hpp"
 #include "labtable.hpp"
 #include "engine.hpp"
+#include "optimizer.hpp"
+#include "typechecker.hpp"
 #include "error.hpp"
 
 void Interpreter::ErrorLine(const char *script, unsigned int line)
@@ -30,10 +32,11 @@ void Interpreter::ErrorLine(const char *script, unsigned int line)
         fclose(fp);
 }
 
-RPNItem *Interpreter::BuildProgram(const char *script, LabTable *L)
+RPNProgram *Interpreter::BuildProgram(const char *script, VarTable *V)
 {
         Scanner B;
         Parser C;
+        LabTable L;
         FILE *fp = fopen(script, "r");
         if (!fp) {
                 perror(script);
@@ -50,49 +53,46 @@ RPNItem *Interpreter::BuildProgram(const char *script, LabTable *L)
                 return 0;
         }
         LexItem *token = B.GetTokenList();
-        RPNItem *prog = 0;
+        RPNProgram *prog = new RPNProgram;
+        Optimizer O;
+        TypeChecker T;
         try {
-                prog = C.Analyze(token, L);
+                C.Analyze(token, prog, &L, V);
+                prog->Verify();
+                O.Run(prog);
+                T.Run(prog, V->Size());
+                prog->Verify();
         }
         catch (const SyntaxError& err) {
                 err.Report();
-                if (err.Token())
-                        ErrorLine(script, err.Token()->line);
+                if (err.Line())
+                        ErrorLine(script, err.Line());
                 fputs("Exception: parsing error\n", stderr);
+                delete prog;
+                return 0;
         }
-        return prog;
-}
-
-void Interpreter::DeleteProgram(RPNItem *prog)
-{
-        RPNItem *tmp;
-        while (prog) {
-                tmp = prog;
-                prog = prog->next;
-                delete tmp->elem;
-                delete tmp;
+        if (stats) {
+                O.Report();
+                T.Report();
         }
+        return prog;
 }
 
 void Interpreter::RunScript(const char *script)
 {
         VarTable V;
-        LabTable L;
-        RPNItem *prog, *cur_cmd, *stack = 0;
-        prog = BuildProgram(script, &L);
+        RPNProgram *prog = BuildProgram(script, &V);
         if (!prog)
                 return;
+        RPNEngine E(*prog);
         srand(time(0));
-        cur_cmd = prog;
         try {
-                while (cur_cmd)
-                        cur_cmd->elem->Evaluate(&cur_cmd, &stack, L, V);
+                E.Run(*prog, V);
         }
         catch (const RuntimeError& err) {
                 err.Report();
                 fputs("Exception: runtime error\n", stderr);
         }
-        DeleteProgram(stack);
-        DeleteProgram(prog);
+        delete prog;
 }
 
@@ -1,16 +1,16 @@
 #ifndef INTERPRETER_HPP_SENTRY
 #define INTERPRETER_HPP_SENTRY
 
-class RPNItem;
-class LabTable;
+class RPNProgram;
+class VarTable;
 
 class Interpreter {
+        bool stats;
 public:
-        Interpreter() {}
+        Interpreter(bool show_stats = false) : stats(show_stats) {}
         void RunScript(const char *script);
 private:
-        RPNItem *BuildProgram(const char *script, LabTable *L);
-        void DeleteProgram(RPNItem *prog);
+        RPNProgram *BuildProgram(const char *script, VarTable *V);
         static void ErrorLine(const char *script, unsigned int line);
 };
 
@@ -1,11 +1,16 @@
 #include "labtable.hpp"
 
-bool LabTable::AddLabel(RPNItem *ptr, const char *lab)
+bool LabTable::AddLabel(long addr, const char *lab)
 {
-        return table.Add(ptr, lab);
+        return table.Add(addr, lab);
 }
 
-RPNItem *LabTable::GetLabel(const char *lab) const
+bool LabTable::Find(const char *lab) const
+{
+        return table.Find(lab);
+}
+
+long LabTable::GetLabel(const char *lab) const
 {
         return table[lab];
 }
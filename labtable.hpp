@@ -3,14 +3,13 @@
 
 #include "hashtable.hpp"
 
-class RPNItem;
-
 class LabTable {
-        HashTable<RPNItem*> table;
+        HashTable<long> table;
 public:
         LabTable() {}
-        bool AddLabel(RPNItem *ptr, const char *lab);
-        RPNItem *GetLabel(const char *lab) const;
+        bool AddLabel(long addr, const char *lab);
+        bool Find(const char *lab) const;
+        long GetLabel(const char *lab) const;
 };
 
 #endif
@@ -1,14 +1,16 @@
 #include <cstdio>
+#include <cstring>
 #include "interpreter.hpp"
 
 int main(int argc, char **argv)
 {
-        if (argc < 2) {
+        bool stats = argc > 1 && !strcmp(argv[1], "-s");
+        if (argc < (stats ? 3 : 2)) {
                 fputs("Wrong amount of arguments\n", stderr);
                 return 1;
         }
-        Interpreter I;
-        I.RunScript(argv[1]);
+        Interpreter I(stats);
+        I.RunScript(argv[stats ? 2 : 1]);
         return 0;
 }
 
@@ -0,0 +1,91 @@
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mapfile.hpp"
+#include "error.hpp"
+
+const char MappedFile::magic[8] = { 'R', 'P', 'N', 'A', 'R', 'R', 'A', 'Y' };
+
+MappedFile::MappedFile(const char *name)
+{
+        header = 0;
+        length = 0;
+        fd = open(name, O_RDWR | O_CREAT, 0644);
+        if (fd == -1)
+                throw RuntimeError(name, "cannot open file");
+        if (flock(fd, LOCK_EX | LOCK_NB) == -1) {
+                close(fd);
+                throw RuntimeError(name, "file is already mapped");
+        }
+        struct stat st;
+        if (fstat(fd, &st) == -1)
+                Fail(name);
+        if (st.st_size == 0) {
+                if (ftruncate(fd, sizeof(Header)) == -1)
+                        Fail(name);
+                if (!Map(sizeof(Header)))
+                        Fail(name);
+                memcpy(header->magic, magic, sizeof(magic));
+                header->type = -1;
+                header->count = 0;
+                return;
+        }
+        if (size_t(st.st_size) < sizeof(Header))
+                Fail(name);
+        if (!Map(st.st_size) || memcmp(header->magic, magic, sizeof(magic)))
+                Fail(name);
+}
+
+MappedFile::~MappedFile()
+{
+        if (header)
+                munmap(header, length);
+        if (fd != -1)
+                close(fd);
+}
+
+void MappedFile::Resize(size_t size)
+{
+        size_t len = sizeof(Header) + size;
+        off_t end = len;
+        if (len < size || end < 0 || size_t(end) != len ||
+            ftruncate(fd, end) == -1)
+                throw RuntimeError("bad allocation", "MappedFile");
+        Header *old = header;
+        size_t old_len = length;
+        if (!Map(len))
+                throw RuntimeError("bad allocation", "MappedFile");
+        munmap(old, old_len);
+}
+
+bool MappedFile::Close(size_t size)
+{
+        munmap(header, length);
+        header = 0;
+        bool res = ftruncate(fd, sizeof(Header) + size) == 0;
+        close(fd);
+        fd = -1;
+        return res;
+}
+
+bool MappedFile::Map(size_t len)
+{
+        void *res = mmap(0, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (res == MAP_FAILED)
+                return false;
+        header = (Header *)res;
+        length = len;
+        return true;
+}
+
+void MappedFile::Fail(const char *name)
+{
+        if (header)
+                munmap(header, length);
+        close(fd);
+        throw RuntimeError(name, "bad file format");
+}
+
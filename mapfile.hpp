@@ -0,0 +1,35 @@
+#ifndef MAPFILE_HPP_SENTRY
+#define MAPFILE_HPP_SENTRY
+
+#include <cstddef>
+
+class MappedFile {
+        struct Header {
+                char magic[8];
+                long type;
+                long count;
+        };
+        int fd;
+        Header *header;
+        size_t length;
+        static const char magic[8];
+public:
+        MappedFile(const char *name);
+        ~MappedFile();
+        long Type() const { return header->type; }
+        void SetType(long type) { header->type = type; }
+        unsigned long Count() const { return header->count; }
+        void SetCount(unsigned long count) { header->count = count; }
+        void *Data() const { return header + 1; }
+        size_t Size() const { return length - sizeof(Header); }
+        void Resize(size_t size);
+        bool Close(size_t size);
+private:
+        MappedFile(const MappedFile&);
+        void operator=(const MappedFile&);
+        bool Map(size_t len);
+        void Fail(const char *name);
+};
+
+#endif
+
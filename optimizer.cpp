@@ -0,0 +1,400 @@
+#include <cstdio>
+#include "optimizer.hpp"
+#include "error.hpp"
+
+Optimizer::Optimizer()
+{
+        prog = 0;
+        before = 0;
+        after = 0;
+        folded = 0;
+        merged = 0;
+        for (int i = 0; i < RPNProgram::OpCount(); i++)
+                fired[i] = 0;
+}
+
+void Optimizer::Run(RPNProgram *P)
+{
+        prog = P;
+        before = prog->Size();
+        FoldConstants();
+        FoldAddresses();
+        prog->Compact();
+        FuseSequences();
+        FuseAppends();
+        prog->Compact();
+        after = prog->Size();
+}
+
+void Optimizer::Report()
+{
+        for (int i = 0; i < RPNProgram::OpCount(); i++) {
+                if (fired[i])
+                        fprintf(stderr, "fused %-14s %ld\n",
+                                RPNProgram::Name(RPNOpCode(i)), fired[i]);
+        }
+        if (folded)
+                fprintf(stderr, "folded constants     %ld\n", folded);
+        if (merged)
+                fprintf(stderr, "merged print args    %ld\n", merged);
+        fprintf(stderr, "instructions   %ld -> %ld\n", before, after);
+}
+
+void Optimizer::FoldConstants()
+{
+        Buffer<long> from;
+        long sp = 0;
+        for (long i = 0; i < prog->Size(); i++) {
+                RPNInstr& cmd = (*prog)[i];
+                long pops = prog->Pops(i);
+                long pushes = prog->Pushes(i);
+                sp -= pops;
+                bool constant = true;
+                for (long j = 0; j < pops; j++) {
+                        if (!RPNProgram::IsConstant((*prog)[from[sp + j]].op))
+                                constant = false;
+                }
+                if (constant && cmd.op == rpn_jump_false) {
+                        FoldBranch(from[sp], i);
+                } else if (constant && cmd.op == rpn_print) {
+                        MergePrint(from, sp, i);
+                } else if (constant && pops && IsPure(cmd.op)) {
+                        Evaluate(from[sp], i);
+                }
+                for (long j = 0; j < pushes; j++)
+                        from[sp++] = i;
+        }
+}
+
+void Optimizer::FoldBranch(long cond, long idx)
+{
+        if ((*prog)[cond].op != rpn_push_bool)
+                return;
+        bool res = (*prog)[cond].arg.integer;
+        prog->Remove(cond);
+        if (res)
+                prog->Remove(idx);
+        else
+                (*prog)[idx].op = rpn_jump;
+        folded++;
+}
+
+void Optimizer::MergePrint(Buffer<long>& from, long sp, long idx)
+{
+        long count = (*prog)[idx].arg.integer;
+        long last = from[sp];
+        for (long j = 1; j < count; j++) {
+                RPNInstr& dst = (*prog)[last];
+                RPNInstr& src = (*prog)[from[sp + j]];
+                if (dst.op != rpn_push_string || src.op != rpn_push_string) {
+                        last = from[sp + j];
+                        continue;
+                }
+                Value str, tail;
+                str.Set(dst.arg.string);
+                tail.Set(src.arg.string);
+                str.Append(tail);
+                prog->SetConstant(last, str);
+                prog->Remove(from[sp + j]);
+                (*prog)[idx].arg.integer--;
+                merged++;
+        }
+}
+
+void Optimizer::Evaluate(long first, long idx)
+{
+        VarTable V;
+        RPNEngine E(*prog);
+        RPNOpCode op = (*prog)[idx].op;
+        try {
+                E.Run(*prog, V, first, idx + 1);
+        }
+        catch (const RuntimeError&) {
+                (*prog)[idx].op = op;
+                return;
+        }
+        for (long j = first; j < idx; j++)
+                prog->Remove(j);
+        prog->SetConstant(idx, E.Result());
+        folded++;
+}
+
+bool Optimizer::IsPure(RPNOpCode op)
+{
+        return (op >= rpn_plus && op <= rpn_leq) ||
+               (op >= rpn_cast_bool && op <= rpn_cast_string) ||
+               (op >= rpn_abs && op <= rpn_min);
+}
+
+void Optimizer::FoldAddresses()
+{
+        Buffer<long> from;
+        long sp = 0;
+        for (long i = 0; i < prog->Size(); i++) {
+                RPNInstr& cmd = (*prog)[i];
+                long pops = prog->Pops(i);
+                long pushes = prog->Pushes(i);
+                sp -= pops;
+                if (pops && (*prog)[from[sp]].op == rpn_push_addr) {
+                        cmd.slot = (*prog)[from[sp]].arg.integer;
+                        if (cmd.op == rpn_var)
+                                Fuse(from[sp], i, rpn_load);
+                        else if (cmd.op == rpn_index)
+                                Fuse(from[sp], i, rpn_addr_index);
+                        else if (cmd.op == rpn_assign)
+                                Fuse(from[sp], i, rpn_store);
+                        else if (cmd.op == rpn_inc)
+                                Fuse(from[sp], i, rpn_inc_var);
+                        else if (cmd.op == rpn_dec)
+                                Fuse(from[sp], i, rpn_dec_var);
+                        else if (StoreOpOf(cmd.op) != rpn_nop)
+                                Fuse(from[sp], i, StoreOpOf(cmd.op));
+                } else if (pops && cmd.op == rpn_var &&
+                           (*prog)[from[sp]].op == rpn_addr_index) {
+                        cmd.slot = (*prog)[from[sp]].slot;
+                        Fuse(from[sp], i, rpn_load_index);
+                }
+                for (long j = 0; j < pushes; j++)
+                        from[sp++] = i;
+        }
+}
+
+void Optimizer::FuseSequences()
+{
+        Buffer<bool> target;
+        long size = prog->Size();
+        FindTargets(target);
+        for (long i = 0; i + 1 < size; i++) {
+                RPNInstr& cmd = (*prog)[i];
+                RPNInstr& next = (*prog)[i + 1];
+                if (target[i + 1])
+                        continue;
+                if (cmd.op == rpn_push_int && next.op == rpn_store) {
+                        next.arg = cmd.arg;
+                        Fuse(i, i + 1, rpn_assign_int);
+                        i++;
+                } else if (next.op == rpn_jump_false &&
+                           BranchOf(cmd.op) != rpn_nop) {
+                        Fuse(i, i + 1, BranchOf(cmd.op));
+                        i++;
+                } else if (cmd.op == rpn_load && next.op == rpn_push_int &&
+                           i + 2 < size && !target[i + 2]) {
+                        RPNInstr& last = (*prog)[i + 2];
+                        RPNOpCode op = LoadOpOf(last.op, next.arg.integer);
+                        if (op == rpn_nop)
+                                continue;
+                        next.op = rpn_nop;
+                        last.slot = cmd.slot;
+                        last.arg = next.arg;
+                        Fuse(i, i + 2, op);
+                        i += 2;
+                }
+        }
+}
+
+void Optimizer::FuseAppends()
+{
+        Buffer<bool> target;
+        long size = prog->Size();
+        FindTargets(target);
+        for (long i = 1; i + 1 < size; i++) {
+                RPNInstr& next = (*prog)[i + 1];
+                if ((*prog)[i].op == rpn_plus && next.op == rpn_assign &&
+                    !target[i] && !target[i + 1]) {
+                        FuseElementAppend(i, target);
+                        continue;
+                }
+                if ((*prog)[i].op != rpn_plus || next.op != rpn_store ||
+                    target[i] || target[i + 1])
+                        continue;
+                long count = AppendChain(i, next.slot, target);
+                if (!count)
+                        continue;
+                long p = i;
+                for (long j = 0; j < count; j++) {
+                        long start = OperandStart(p - 1, target);
+                        (*prog)[p].op = rpn_plus_store;
+                        (*prog)[p].slot = next.slot;
+                        p = Before(start, target);
+                }
+                prog->Remove(p);
+                prog->Remove(i + 1);
+                fired[rpn_plus_store] += count;
+                i++;
+        }
+}
+
+void Optimizer::FuseElementAppend(long idx, Buffer<bool>& target)
+{
+        long start = OperandStart(idx - 1, target);
+        long load = start < 0 ? -1 : Before(start, target);
+        long index = load < 0 ? -1 : Before(load, target);
+        long addr = index < 0 ? -1 : Before(index, target);
+        long first = addr < 0 ? -1 : Before(addr, target);
+        if (first < 0)
+                return;
+        const RPNInstr& src = (*prog)[load];
+        const RPNInstr& dst = (*prog)[addr];
+        if (src.op != rpn_load_index || dst.op != rpn_addr_index ||
+            src.slot != dst.slot || !SameIndex((*prog)[index], (*prog)[first]))
+                return;
+        prog->Remove(index);
+        prog->Remove(load);
+        prog->Remove(idx + 1);
+        (*prog)[idx].op = rpn_plus_assign;
+        fired[rpn_plus_assign]++;
+}
+
+long Optimizer::AppendChain(long idx, long slot, Buffer<bool>& target) const
+{
+        long count = 0;
+        bool reads = false;
+        for (;;) {
+                long start = OperandStart(idx - 1, target);
+                long before = start < 0 ? -1 : Before(start, target);
+                if (before < 0)
+                        return 0;
+                for (long i = start; i < idx; i++)
+                        reads = reads || Reads((*prog)[i], slot);
+                count++;
+                const RPNInstr& prev = (*prog)[before];
+                if (prev.op == rpn_load && prev.slot == slot)
+                        break;
+                if (prev.op != rpn_plus)
+                        return 0;
+                idx = before;
+        }
+        return count > 1 && reads ? 0 : count;
+}
+
+long Optimizer::Before(long idx, Buffer<bool>& target) const
+{
+        for (long i = idx - 1; i >= 0; i--) {
+                if (target[i + 1])
+                        return -1;
+                if ((*prog)[i].op != rpn_nop)
+                        return i;
+        }
+        return -1;
+}
+
+bool Optimizer::Reads(const RPNInstr& cmd, long slot)
+{
+        switch (cmd.op) {
+        case rpn_push_addr:
+                return cmd.arg.integer == slot;
+        case rpn_load:
+        case rpn_load_index:
+        case rpn_addr_index:
+        case rpn_load_plus_int:
+        case rpn_load_minus_int:
+        case rpn_load_mul_int:
+        case rpn_load_div_int:
+        case rpn_load_mod_int:
+                return cmd.slot == slot;
+        default:
+                return false;
+        }
+}
+
+bool Optimizer::SameIndex(const RPNInstr& a, const RPNInstr& b)
+{
+        if (a.op != b.op)
+                return false;
+        if (a.op == rpn_push_int)
+                return a.arg.integer == b.arg.integer;
+        return a.op == rpn_load && a.slot == b.slot;
+}
+
+void Optimizer::FindTargets(Buffer<bool>& target) const
+{
+        long size = prog->Size();
+        for (long i = 0; i <= size; i++)
+                target[i] = false;
+        for (long i = 0; i < size; i++) {
+                if (RPNProgram::IsJump((*prog)[i].op))
+                        target[(*prog)[i].arg.integer] = true;
+        }
+}
+
+long Optimizer::OperandStart(long idx, Buffer<bool>& target) const
+{
+        long need = 1;
+        for (long i = idx; i >= 0; i--) {
+                if (i < idx && target[i + 1])
+                        return -1;
+                if ((*prog)[i].op == rpn_nop)
+                        continue;
+                long pushes = prog->Pushes(i);
+                if (pushes == 0 || pushes > need)
+                        return -1;
+                need += prog->Pops(i) - pushes;
+                if (need == 0)
+                        return i;
+        }
+        return -1;
+}
+
+void Optimizer::Fuse(long from, long to, RPNOpCode op)
+{
+        prog->Remove(from);
+        (*prog)[to].op = op;
+        fired[op]++;
+}
+
+RPNOpCode Optimizer::StoreOpOf(RPNOpCode op)
+{
+        switch (op) {
+        case rpn_plus_assign:
+                return rpn_plus_store;
+        case rpn_minus_assign:
+                return rpn_minus_store;
+        case rpn_mul_assign:
+                return rpn_mul_store;
+        case rpn_div_assign:
+                return rpn_div_store;
+        case rpn_mod_assign:
+                return rpn_mod_store;
+        default:
+                return rpn_nop;
+        }
+}
+
+RPNOpCode Optimizer::BranchOf(RPNOpCode op)
+{
+        switch (op) {
+        case rpn_equ:
+                return rpn_equ_jump;
+        case rpn_neq:
+                return rpn_neq_jump;
+        case rpn_gtr:
+                return rpn_gtr_jump;
+        case rpn_lss:
+                return rpn_lss_jump;
+        case rpn_geq:
+                return rpn_geq_jump;
+        case rpn_leq:
+                return rpn_leq_jump;
+        default:
+                return rpn_nop;
+        }
+}
+
+RPNOpCode Optimizer::LoadOpOf(RPNOpCode op, long val)
+{
+        switch (op) {
+        case rpn_plus:
+                return rpn_load_plus_int;
+        case rpn_minus:
+                return rpn_load_minus_int;
+        case rpn_mul:
+                return rpn_load_mul_int;
+        case rpn_div:
+                return val ? rpn_load_div_int : rpn_nop;
+        case rpn_mod:
+                return val ? rpn_load_mod_int : rpn_nop;
+        default:
+                return rpn_nop;
+        }
+}
+
@@ -0,0 +1,41 @@
+#ifndef OPTIMIZER_HPP_SENTRY
+#define OPTIMIZER_HPP_SENTRY
+
+#include "engine.hpp"
+#include "buffer.hpp"
+
+class Optimizer {
+        RPNProgram *prog;
+        Buffer<long> fired;
+        long before;
+        long after;
+        long folded;
+        long merged;
+public:
+        Optimizer();
+        void Run(RPNProgram *P);
+        void Report();
+private:
+        void FoldConstants();
+        void FoldBranch(long cond, long idx);
+        void MergePrint(Buffer<long>& from, long sp, long idx);
+        void Evaluate(long first, long idx);
+        void FoldAddresses();
+        void FuseSequences();
+        void Fuse(long from, long to, RPNOpCode op);
+        void FuseAppends();
+        void FuseElementAppend(long idx, Buffer<bool>& target);
+        void FindTargets(Buffer<bool>& target) const;
+        long AppendChain(long idx, long slot, Buffer<bool>& target) const;
+        long OperandStart(long idx, Buffer<bool>& target) const;
+        long Before(long idx, Buffer<bool>& target) const;
+        static bool IsPure(RPNOpCode op);
+        static bool Reads(const RPNInstr& cmd, long slot);
+        static bool SameIndex(const RPNInstr& a, const RPNInstr& b);
+        static RPNOpCode BranchOf(RPNOpCode op);
+        static RPNOpCode StoreOpOf(RPNOpCode op);
+        static RPNOpCode LoadOpOf(RPNOpCode op, long val);
+};
+
+#endif
+
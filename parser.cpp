@@ -2,23 +2,26 @@
 #include <cstring>
 #include "parser.hpp"
 #include "error.hpp"
-#include "buffer.hpp"
 
 Parser::Parser()
 {
         cur_lex = 0;
-        stack = 0;
-        last = 0;
         prog = 0;
+        tab = 0;
+        vars = 0;
+        gotos = 0;
 }
 
-RPNItem *Parser::Analyze(LexItem *tokens, LabTable *L)
+void Parser::Analyze(LexItem *tokens, RPNProgram *P, LabTable *L, VarTable *V)
 {
         cur_lex = tokens;
+        prog = P;
         tab = L;
+        vars = V;
         if (cur_lex) {
                 S();
-                return prog;
+                Link();
+                return;
         }
         throw SyntaxError("no input tokens", cur_lex);
 }
@@ -63,6 +66,7 @@ void Parser::A()
 
 void Parser::B()
 {
+        prog->SetLine(cur_lex->line);
         if (IsLex("if")) {
                 B1();
         } else if (IsLex("while")) {
@@ -83,20 +87,29 @@ void Parser::B()
         } else if (IsLex("print")) {
                 Next();
                 B7();
+        } else if (IsLex("push")) {
+                Next();
+                B11();
+        } else if (IsLex("copy")) {
+                Next();
+                B12();
+        } else if (IsLex("map")) {
+                Next();
+                B13();
         } else if (IsLex("scan")) {
                 Next();
                 B8();
-                Add(new RPNFunScan);
+                prog->Emit(rpn_scan);
         } else if (IsLex("inc")) {
                 Next();
                 B8();
-                Add(new RPNFunInc);
+                prog->Emit(rpn_inc);
         } else if (IsLex("dec")) {
                 Next();
                 B8();
-                Add(new RPNFunDec);
+                prog->Emit(rpn_dec);
         } else if (IsVariable()) {
-                Add(new RPNAddr(cur_lex->token));
+                AddAddr();
                 Next();
                 D();
                 B9();
@@ -109,64 +122,54 @@ void Parser::B()
 
 void Parser::B1()
 {
-        Buffer<RPNItem*> exit_if;
+        Buffer<long> exit_if;
         int branches = 0;
         do {
                 Next();
-                RPNItem *tmp = Blank();
                 C1();
-                Add(new RPNJumpFalse);
+                long tmp = prog->Emit(rpn_jump_false);
                 A();
-                exit_if[branches] = Blank();
+                exit_if[branches] = prog->Emit(rpn_jump);
                 branches++;
-                Add(new RPNJump);
-                Add(new RPNFunNull);
-                tmp->elem = new RPNLabel(last);
+                prog->SetTarget(tmp, prog->Size());
         } while (IsLex("elseif"));
         if (IsLex("else")) {
                 Next();
                 A();
         }
-        Add(new RPNFunNull);
         for (int i = 0; i < branches; i++)
-                exit_if[i]->elem = new RPNLabel(last);
+                prog->SetTarget(exit_if[i], prog->Size());
 }
 
 void Parser::B2()
 {
-        Add(new RPNFunNull);
-        RPNItem *tmp2 = last;
-        RPNItem *tmp = Blank();
+        long tmp2 = prog->Size();
         C1();
-        Add(new RPNJumpFalse);
+        long tmp = prog->Emit(rpn_jump_false);
         A();
-        Add(new RPNLabel(tmp2));
-        Add(new RPNJump);
-        Add(new RPNFunNull);
-        tmp->elem = new RPNLabel(last);
+        prog->Emit(rpn_jump, tmp2);
+        prog->SetTarget(tmp, prog->Size());
 }
 
 void Parser::B3()
 {
-        Add(new RPNFunNull);
-        RPNItem *tmp = last;
+        long tmp = prog->Size();
         A();
-        Add(new RPNLabel(tmp));
         if (!IsLex("until"))
                 throw SyntaxError("expected keyword 'until'", cur_lex);
         Next();
         C1();
-        Add(new RPNJumpFalse);
+        prog->Emit(rpn_jump_false, tmp);
 }
 
 void Parser::B4()
 {
         if (!IsLabel())
                 throw SyntaxError("expected label", cur_lex);
-        Add(new RPNValue(cur_lex->token));
+        goto_cmd[gotos] = prog->Emit(rpn_jump);
+        goto_lex[gotos] = cur_lex;
+        gotos++;
         Next();
-        Add(new RPNFunLab);
-        Add(new RPNJump);
         if (!IsLex(";"))
                 throw SyntaxError("expected ';'", cur_lex);
         Next();
@@ -175,13 +178,13 @@ void Parser::B4()
 void Parser::B5()
 {
         if (IsVariable()) {
-                Add(new RPNAddr(cur_lex->token));
+                AddAddr();
                 Next();
                 C1();
         } else {
                 throw SyntaxError("expected variable", cur_lex);
         }
-        Add(new RPNFunAlloc);
+        prog->Emit(rpn_alloc);
         if (!IsLex(";"))
                 throw SyntaxError("expected ';'", cur_lex);
         Next();
@@ -190,12 +193,12 @@ void Parser::B5()
 void Parser::B6()
 {
         if (IsVariable()) {
-                Add(new RPNAddr(cur_lex->token));
+                AddAddr();
                 Next();
         } else {
                 throw SyntaxError("expected variable", cur_lex);
         }
-        Add(new RPNFunFree);
+        prog->Emit(rpn_free);
         if (!IsLex(";"))
                 throw SyntaxError("expected ';'", cur_lex);
         Next();
@@ -203,19 +206,21 @@ void Parser::B6()
 
 void Parser::B7()
 {
+        long count = 0;
 again:
         if (IsLex("endl")) {
-                Add(new RPNValue("\n"));
+                prog->EmitString(rpn_push_string, "\n");
                 Next();
         } else {
                 C1();
-                Add(new RPNFunCastString);
+                prog->Emit(rpn_cast_string);
         }
+        count++;
         if (IsLex(",")) {
                 Next();
                 goto again;
         }
-        Add(new RPNFunPrint);
+        prog->Emit(rpn_print, count);
         if (!IsLex(";"))
                 throw SyntaxError("expected ';'", cur_lex);
         Next();
@@ -225,7 +230,7 @@ void Parser::B8()
 {
         if (!IsVariable())
                 throw SyntaxError("expected variable", cur_lex);
-        Add(new RPNAddr(cur_lex->token));
+        AddAddr();
         Next();
         D();
         if (!IsLex(";"))
@@ -235,11 +240,24 @@ void Parser::B8()
 
 void Parser::B9()
 {
-        if (!IsLex("="))
+        RPNOpCode op;
+        if (IsLex("="))
+                op = rpn_assign;
+        else if (IsLex("+="))
+                op = rpn_plus_assign;
+        else if (IsLex("-="))
+                op = rpn_minus_assign;
+        else if (IsLex("*="))
+                op = rpn_mul_assign;
+        else if (IsLex("/="))
+                op = rpn_div_assign;
+        else if (IsLex("%="))
+                op = rpn_mod_assign;
+        else
                 throw SyntaxError("expected operator '='", cur_lex);
         Next();
         C1();
-        Add(new RPNFunAssign);
+        prog->Emit(op);
         if (!IsLex(";"))
                 throw SyntaxError("expected ';'", cur_lex);
         Next();
@@ -247,8 +265,7 @@ void Parser::B9()
 
 void Parser::B10()
 {
-        Add(new RPNFunNull);
-        bool res = tab->AddLabel(last, cur_lex->token);
+        bool res = tab->AddLabel(prog->Size(), cur_lex->token);
         if (!res)
                 throw SyntaxError("duplicate label", cur_lex);
         Next();
@@ -257,14 +274,69 @@ void Parser::B10()
         Next();
 }
 
+void Parser::B11()
+{
+        if (IsVariable()) {
+                AddAddr();
+                Next();
+                C1();
+        } else {
+                throw SyntaxError("expected variable", cur_lex);
+        }
+        prog->Emit(rpn_append);
+        if (!IsLex(";"))
+                throw SyntaxError("expected ';'", cur_lex);
+        Next();
+}
+
+void Parser::B12()
+{
+        for (int i = 0; i < 2; i++) {
+                if (!IsVariable())
+                        throw SyntaxError("expected variable", cur_lex);
+                AddAddr();
+                Next();
+        }
+        prog->Emit(rpn_copy);
+        if (!IsLex(";"))
+                throw SyntaxError("expected ';'", cur_lex);
+        Next();
+}
+
+void Parser::B13()
+{
+        if (!IsVariable())
+                throw SyntaxError("expected variable", cur_lex);
+        AddAddr();
+        Next();
+        C1();
+        DataType type;
+        if (IsLex("bool"))
+                type = bool_type;
+        else if (IsLex("int"))
+                type = int_type;
+        else if (IsLex("double"))
+                type = double_type;
+        else
+                throw SyntaxError("expected type", cur_lex);
+        Next();
+        if (IsLex(";"))
+                prog->Emit(rpn_push_int, 0);
+        else
+                C1();
+        prog->Emit(rpn_map, type);
+        if (!IsLex(";"))
+                throw SyntaxError("expected ';'", cur_lex);
+        Next();
+}
+
 void Parser::C1()
 {
         C2();
         while (IsLex("~") || IsLex("equ")) {
-                Push(new RPNFunEQ);
                 Next();
                 C2();
-                Add(Pop());
+                prog->Emit(rpn_eq);
         }
 }
 
@@ -272,13 +344,10 @@ void Parser::C2()
 {
         C3();
         while (IsLex("|") || IsLex("^") || IsLex("or") || IsLex("xor")) {
-                if (IsLex("|") || IsLex("or"))
-                        Push(new RPNFunOR);
-                else
-                        Push(new RPNFunXOR);
+                RPNOpCode op = IsLex("|") || IsLex("or") ? rpn_or : rpn_xor;
                 Next();
                 C3();
-                Add(Pop());
+                prog->Emit(op);
         }
 }
 
@@ -286,10 +355,9 @@ void Parser::C3()
 {
         C4();
         while (IsLex("&") || IsLex("and")) {
-                Push(new RPNFunAND);
                 Next();
                 C4();
-                Add(Pop());
+                prog->Emit(rpn_and);
         }
 }
 
@@ -298,21 +366,22 @@ void Parser::C4()
         C5();
         if (IsLex("==")||IsLex(">=")||IsLex(">")||
             IsLex("!=")||IsLex("<=")||IsLex("<")){
+                RPNOpCode op;
                 if (IsLex("=="))
-                        Push(new RPNFunEQU);
+                        op = rpn_equ;
                 else if (IsLex("!="))
-                        Push(new RPNFunNEQ);
+                        op = rpn_neq;
                 else if (IsLex(">="))
-                        Push(new RPNFunGEQ);
+                        op = rpn_geq;
                 else if (IsLex("<="))
-                        Push(new RPNFunLEQ);
+                        op = rpn_leq;
                 else if (IsLex(">"))
-                        Push(new RPNFunGTR);
+                        op = rpn_gtr;
                 else
-                        Push(new RPNFunLSS);
+                        op = rpn_lss;
                 Next();
                 C5();
-                Add(Pop());
+                prog->Emit(op);
         }
 }
 
@@ -320,13 +389,10 @@ void Parser::C5()
 {
         C6();
         while (IsLex("+") || IsLex("-")) {
-                if (IsLex("+"))
-                        Push(new RPNFunPlus);
-                else
-                        Push(new RPNFunMinus);
+                RPNOpCode op = IsLex("+") ? rpn_plus : rpn_minus;
                 Next();
                 C6();
-                Add(Pop());
+                prog->Emit(op);
         }
 }
 
@@ -334,28 +400,26 @@ void Parser::C6()
 {
         C7();
         while (IsLex("*") || IsLex("/") || IsLex("%")) {
+                RPNOpCode op;
                 if (IsLex("*"))
-                        Push(new RPNFunMul);
+                        op = rpn_mul;
                 else if (IsLex("/"))
-                        Push(new RPNFunDiv);
+                        op = rpn_div;
                 else
-                        Push(new RPNFunMod);
+                        op = rpn_mod;
                 Next();
                 C7();
-                Add(Pop());
+                prog->Emit(op);
         }
 }
 
 void Parser::C7()
 {
         if (IsLex("-") || IsLex("!") || IsLex("not")) {
-                if (IsLex("-"))
-                        Push(new RPNFunUMinus);
-                else
-                        Push(new RPNFunNOT);
+                RPNOpCode op = IsLex("-") ? rpn_uminus : rpn_not;
                 Next();
                 C8();
-                Add(Pop());
+                prog->Emit(op);
         } else {
                 C8();
         }
@@ -364,26 +428,26 @@ void Parser::C7()
 void Parser::C8()
 {
         if (IsVariable()) {
-                Add(new RPNAddr(cur_lex->token));
+                AddAddr();
                 Next();
                 D();
-                Add(new RPNFunVar);
+                prog->Emit(rpn_var);
         } else if (IsFunction() || IsCast()) {
-                Push(NewFunction());
+                RPNOpCode op = NewFunction();
                 Next();
                 E();
-                Add(Pop());
+                prog->Emit(op);
         } else if (IsString()) {
-                Add(new RPNValue(cur_lex->token));
+                prog->EmitString(rpn_push_string, cur_lex->token);
                 Next();
         } else if (IsConstant()) {
                 if (strchr(cur_lex->token, '.'))
-                        Add(new RPNValue(atof(cur_lex->token)));
+                        prog->EmitReal(rpn_push_double, atof(cur_lex->token));
                 else
-                        Add(new RPNValue(atol(cur_lex->token)));
+                        prog->Emit(rpn_push_int, atol(cur_lex->token));
                 Next();
         } else if (IsBool()) {
-                Add(new RPNValue(IsLex("true")));
+                prog->Emit(rpn_push_bool, IsLex("true"));
                 Next();
         } else if (IsLex("(")) {
                 Next();
@@ -404,7 +468,7 @@ void Parser::D()
                 if (!IsLex("]"))
                         throw SyntaxError("expected ']'", cur_lex);
                 Next();
-                Add(new RPNFunIndex);
+                prog->Emit(rpn_index);
         }
 }
 
@@ -425,93 +489,71 @@ void Parser::E()
         Next();
 }
 
-void Parser::Add(RPNElem *unit)
-{
-        RPNItem *tmp = Blank();
-        tmp->elem = unit;
-}
-
-void Parser::Push(RPNElem *unit)
-{
-        RPNItem *tmp = new RPNItem;
-        tmp->elem = unit;
-        tmp->next = stack;
-        stack = tmp;
-}
-
-RPNElem *Parser::Pop()
-{
-        RPNElem *unit = stack->elem;
-        RPNItem *tmp = stack;
-        stack = stack->next;
-        delete tmp;
-        return unit;
-}
-
-RPNItem *Parser::Blank()
-{
-        if (last) {
-                last->next = new RPNItem;
-                last = last->next;
-        } else {
-                prog = new RPNItem;
-                last = prog;
-        }
-        last->next = 0;
-        return last;
-}
-
-RPNElem *Parser::NewFunction() const
+RPNOpCode Parser::NewFunction() const
 {
         if (IsLex("bool"))
-                return new RPNFunCastBool;
+                return rpn_cast_bool;
         if (IsLex("int"))
-                return new RPNFunCastInt;
+                return rpn_cast_int;
         if (IsLex("double"))
-                return new RPNFunCastDouble;
+                return rpn_cast_double;
         if (IsLex("string"))
-                return new RPNFunCastString;
+                return rpn_cast_string;
         if (IsLex("?rand"))
-                return new RPNFunRand;
+                return rpn_rand;
         if (IsLex("?abs"))
-                return new RPNFunAbs;
+                return rpn_abs;
         if (IsLex("?pow"))
-                return new RPNFunPow;
+                return rpn_pow;
         if (IsLex("?sqrt"))
-                return new RPNFunSqrt;
+                return rpn_sqrt;
         if (IsLex("?sin"))
-                return new RPNFunSin;
+                return rpn_sin;
         if (IsLex("?cos"))
-                return new RPNFunCos;
+                return rpn_cos;
         if (IsLex("?tan"))
-                return new RPNFunTan;
+                return rpn_tan;
         if (IsLex("?asin"))
-                return new RPNFunAsin;
+                return rpn_asin;
         if (IsLex("?acos"))
-                return new RPNFunAcos;
+                return rpn_acos;
         if (IsLex("?atan"))
-                return new RPNFunAtan;
+                return rpn_atan;
         if (IsLex("?atan2"))
-                return new RPNFunAtan2;
+                return rpn_atan2;
         if (IsLex("?exp"))
-                return new RPNFunExp;
+                return rpn_exp;
         if (IsLex("?log"))
-                return new RPNFunLog;
+                return rpn_log;
         if (IsLex("?ceil"))
-                return new RPNFunCeil;
+                return rpn_ceil;
         if (IsLex("?floor"))
-                return new RPNFunFloor;
+                return rpn_floor;
         if (IsLex("?trunc"))
-                return new RPNFunTrunc;
+                return rpn_trunc;
         if (IsLex("?round"))
-                return new RPNFunRound;
+                return rpn_round;
         if (IsLex("?max"))
-                return new RPNFunMax;
+                return rpn_max;
         if (IsLex("?min"))
-                return new RPNFunMin;
+                return rpn_min;
         throw SyntaxError("unknown function", cur_lex);
 }
 
+void Parser::AddAddr()
+{
+        prog->Emit(rpn_push_addr, vars->Resolve(cur_lex->token));
+}
+
+void Parser::Link()
+{
+        for (int i = 0; i < gotos; i++) {
+                if (!tab->Find(goto_lex[i]->token))
+                        throw SyntaxError("unknown label", goto_lex[i]);
+                prog->SetTarget(goto_cmd[i], tab->GetLabel(goto_lex[i]->token));
+        }
+}
+
 bool Parser::IsLex(const char *str) const
 {
         return !strcmp(cur_lex->token, str);
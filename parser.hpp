@@ -4,16 +4,19 @@
 #include "engine.hpp"
 #include "scanner.hpp"
 #include "labtable.hpp"
+#include "buffer.hpp"
 
 class Parser {
         LexItem *cur_lex;
-        RPNItem *stack;
-        RPNItem *last;
-        RPNItem *prog;
+        RPNProgram *prog;
         LabTable *tab;
+        VarTable *vars;
+        Buffer<long> goto_cmd;
+        Buffer<LexItem*> goto_lex;
+        int gotos;
 public:
         Parser();
-        RPNItem *Analyze(LexItem *tokens, LabTable *L);
+        void Analyze(LexItem *tokens, RPNProgram *P, LabTable *L, VarTable *V);
 private:
         void Next();
         void S();
@@ -29,6 +32,9 @@ private:
         void B8();
         void B9();
         void B10();
+        void B11();
+        void B12();
+        void B13();
         void C1();
         void C2();
         void C3();
@@ -39,11 +45,9 @@ private:
         void C8();
         void D();
         void E();
-        void Add(RPNElem *unit);
-        void Push(RPNElem *unit);
-        RPNElem *Pop();
-        RPNItem *Blank();
-        RPNElem *NewFunction() const;
+        void AddAddr();
+        void Link();
+        RPNOpCode NewFunction() const;
         bool IsLex(const char *str) const;
         bool IsVariable() const;
         bool IsFunction() const;
@@ -9,7 +9,8 @@ const char *const Scanner::keywords[] = {
         "goto",    "while", "repeat", "until",
         "alloc",   "free",  "print",  "scan",
         "inc",     "dec",   "true",   "false",
-        "bool",    "int",   "double", "string"
+        "bool",    "int",   "double", "string",
+        "push",    "copy",  "map"
 };
 
 Scanner::Scanner()
@@ -27,15 +28,7 @@ Scanner::Scanner()
 
 Scanner::~Scanner()
 {
-        LexItem *tmp;
-        while (token_list) {
-                tmp = token_list;
-                token_list = token_list->next;
-                delete[] tmp->token;
-                delete tmp;
-        }
         DisposeBuffer();
-
 }
 
 void Scanner::Feed(char c)
@@ -105,7 +98,9 @@ void Scanner::HandleHome(char c)
                 flag = quote;
         } else {
                 Append(c);
-                if (IsOperation(c)) {
+                if (strchr("+-*/%", c)) {
+                        flag = equal;
+                } else if (IsOperation(c)) {
                         AddLexeme(operation);
                 } else if (IsPunctuator(c)) {
                         AddLexeme(punctuator);
@@ -236,18 +231,18 @@ void Scanner::AddLexeme(enum token_type type)
 {
         if (buf_used == 0)
                 return;
-        if (last_ptr) {
-                last_ptr->next = new LexItem;
-                last_ptr = last_ptr->next;
-        } else {
-                token_list = new LexItem;
-                last_ptr = token_list;
-        }
+        LexItem *item = (LexItem *)pool.Alloc(sizeof(LexItem));
+        if (last_ptr)
+                last_ptr->next = item;
+        else
+                token_list = item;
+        last_ptr = item;
         last_ptr->next = 0;
         last_ptr->token = GetString();
         last_ptr->type = type;
         last_ptr->line = current_line;
-        DisposeBuffer();
+        buf_used = 0;
+        buffer[0] = 0;
 }
 
 void Scanner::AllocateBuffer()
@@ -272,12 +267,10 @@ void Scanner::DisposeBuffer()
         }
 }
 
-char *Scanner::GetString() const
+char *Scanner::GetString()
 {
-        char *str = new char[buf_used + 1];
-        for (int i = 0; i < buf_used; i++)
-                str[i] = buffer[i];
-        str[buf_used] = 0;
+        char *str = (char *)pool.Alloc(buf_used + 1);
+        memcpy(str, buffer, buf_used + 1);
         return str;
 }
 
@@ -1,6 +1,8 @@
 #ifndef SCANNER_HPP_SENTRY
 #define SCANNER_HPP_SENTRY
 
+#include "arena.hpp"
+
 enum token_type {
         identifier,
         keyword,
@@ -39,6 +41,7 @@ class Scanner {
         char *buffer;
         LexItem *token_list;
         LexItem *last_ptr;
+        Arena pool;
         static const char *const keywords[];
 public:
         Scanner();
@@ -63,12 +66,14 @@ private:
         void AddLexeme(enum token_type type);
         void AllocateBuffer();
         void DisposeBuffer();
-        char *GetString() const;
+        char *GetString();
         static bool IsOperation(char c);
         static bool IsPunctuator(char c);
         static bool IsDelimiter(char c);
         static bool IsKeyword(const char *token);
         static bool IsFunction(const char *token);
+        Scanner(const Scanner&);
+        void operator=(const Scanner&);
 };
 
 #endif
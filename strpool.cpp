@@ -0,0 +1,19 @@
+#include "strpool.hpp"
+
+StringPool::~StringPool()
+{
+        for (long i = 0; i < count; i++)
+                strings[i]->Unref();
+}
+
+StringData *StringPool::Intern(const char *str, long len)
+{
+        bool added;
+        StringData *&res = table.FindOrAdd(0, str, added);
+        if (added) {
+                res = StringData::Create(str, len);
+                strings[count++] = res;
+        }
+        return res;
+}
+
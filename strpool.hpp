@@ -0,0 +1,23 @@
+#ifndef STRPOOL_HPP_SENTRY
+#define STRPOOL_HPP_SENTRY
+
+#include "hashtable.hpp"
+#include "buffer.hpp"
+#include "value.hpp"
+
+class StringPool {
+        HashTable<StringData *> table;
+        Buffer<StringData *> strings;
+        long count;
+public:
+        StringPool() : count(0) {}
+        ~StringPool();
+        StringData *Intern(const char *str, long len);
+        StringData *Intern(const char *str) { return Intern(str, strlen(str)); }
+private:
+        StringPool(const StringPool&);
+        void operator=(const StringPool&);
+};
+
+#endif
+
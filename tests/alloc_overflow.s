@@ -0,0 +1,6 @@
+program "alloc_overflow";
+begin {
+        alloc $a -1;
+        $a[100000] = 1;
+        print "unreachable", endl;
+} end
@@ -0,0 +1,30 @@
+program "compound";
+begin {
+        $i = 10;
+        $i += 5;
+        $i -= 3;
+        $i *= 4;
+        $i /= 6;
+        $i %= 5;
+        $d = 1.5;
+        $d += 2.25;
+        $d -= 0.75;
+        $d *= 3.0;
+        $d /= 2.0;
+        $s = "ab";
+        $s += "cd";
+        $s += $s;
+        alloc $a 3;
+        $a[1] = 7;
+        $a[1] += 8;
+        $a[1] %= 4;
+        $a[2] = "q";
+        $a[2] += "rs";
+        inc $a[0];
+        dec $i;
+        $x = 9;
+        $y = 4;
+        print $i, " ", $d, " ", $s, endl;
+        print $a[0], " ", $a[1], " ", $a[2], endl;
+        print $x-$y, " ", $x - -1, " ", $x--1, endl;
+} end
@@ -0,0 +1,18 @@
+program "copy";
+begin {
+        alloc $a 4;
+        $a[0] = 1;
+        $a[1] = 2;
+        $a[2] = "str";
+        copy $b $a;
+        copy $c $b;
+        $b[0] = 10;
+        $b[2] += "ing";
+        push $c 99;
+        inc $c[1];
+        print $a[0], " ", $a[1], " ", $a[2], " ", $a[3], endl;
+        print $b[0], " ", $b[1], " ", $b[2], " ", $b[3], endl;
+        print $c[0], " ", $c[1], " ", $c[2], " ", $c[4], endl;
+        free $a;
+        print $b[1], " ", $c[2], endl;
+} end
@@ -0,0 +1,14 @@
+program "goto";
+begin {
+        $i = 0;
+        $sum = 0;
+@again:
+        $sum = $sum + $i;
+        inc $i;
+        if $i < 10
+                goto @again;
+        goto @done;
+        print "skipped", endl;
+@done:
+        print $sum, " ", $i, endl;
+} end
@@ -0,0 +1,5 @@
+program "goto_unknown";
+begin {
+        print "never printed", endl;
+        goto @missing;
+} end
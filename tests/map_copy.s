@@ -0,0 +1,17 @@
+program "map_copy";
+begin {
+        map $d "tests/map_copy.bin" int 10;
+        copy $e $d;
+        $d[0] = 777;
+        $e[1] = 5;
+        print $d[0], " ", $e[0], " ", $d[1], " ", $e[1], endl;
+        free $d;
+        free $e;
+        map $d "tests/map_copy.bin" int;
+        print $d[0], " ", $d[1], endl;
+        copy $d $d;
+        $d[2] = 3;
+        free $d;
+        map $d "tests/map_copy.bin" int;
+        print $d[2], endl;
+} end
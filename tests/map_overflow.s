@@ -0,0 +1,6 @@
+program "map_overflow";
+begin {
+        map $d "tests/map_overflow.bin" int -1;
+        $d[100000] = 1;
+        print "unreachable", endl;
+} end
@@ -0,0 +1,10 @@
+program "map_twice";
+begin {
+        map $a "tests/map_twice.bin" int 4;
+        $a[1] = 7;
+        free $a;
+        map $b "tests/map_twice.bin" int;
+        map $b "tests/map_twice.bin" int;
+        print $b[1], endl;
+        map $c "tests/map_twice.bin" int 4;
+} end
@@ -0,0 +1,18 @@
+program "push";
+begin {
+        alloc $a 2;
+        $a[0] = 5;
+        $a[1] = 6;
+        $i = 0;
+        while $i < 1000 {
+                push $a $i * 3;
+                $i = $i + 1;
+        }
+        push $a 2.5;
+        push $a "end";
+        push $b "first";
+        push $b "second";
+        print $a[0], " ", $a[1], " ", $a[2], " ", $a[501], " ", $a[1001], endl;
+        print $a[1002], " ", $a[1003], " ", $b[0], " ", $b[1], endl;
+        print $a[1004], endl;
+} end
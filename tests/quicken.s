@@ -0,0 +1,21 @@
+program "quicken";
+begin {
+        alloc $a 6;
+        $a[0] = 1;
+        $a[1] = 2;
+        $a[2] = 3;
+        $a[3] = 1.5;
+        $a[4] = "x";
+        $a[5] = 4;
+        $i = 0;
+        while $i < 6 {
+                $v = $a[$i] + $a[$i];
+                if $v < $v + $a[$i]
+                        print $i, " less ", $v, endl;
+                else
+                        print $i, " ", $v, endl;
+                $i = $i + 1;
+        }
+        $m = 7 * $a[1] - $a[5] % 3;
+        print $m, endl;
+} end
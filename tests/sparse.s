@@ -0,0 +1,29 @@
+program "sparse";
+begin {
+        alloc $m 10000000;
+        $m[3] = 1.5;
+        $m[4] = "s";
+        $m[5000] = true;
+        inc $m[7];
+        $m[9999999] += 2;
+        $m[8] = "a";
+        $m[8] = $m[8] + "b";
+        copy $c $m;
+        $c[3] = 0;
+        print $m[3], " ", $m[4], " ", $m[5000], " ", $m[7], " ", $m[9999999], " ", $m[8], " ", $c[3], " ", $m[6], endl;
+        alloc $m 4000;
+        print $m[3], " ", $c[9999999], endl;
+        alloc $m 20000000;
+        print $m[3], " ", $m[19999999], endl;
+        $i = 0;
+        while ($i < 10000000) {
+                $m[$i] = $i;
+                $i = $i + 1024;
+        }
+        $i = 0;
+        while ($i < 10000000) {
+                $c[$i] = $i;
+                $i = $i + 1;
+        }
+        print $m[1024], " ", $m[4096], " ", $c[9999999], " ", $m[9999999], " ", $c[4], endl;
+} end
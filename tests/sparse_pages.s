@@ -0,0 +1,15 @@
+program "sparse_pages";
+begin {
+        alloc $m 10000000;
+        $i = 0;
+        while ($i < 10000000) {
+                $m[$i] = $i;
+                $i = $i + 1024;
+        }
+        $m[2048] = 0;
+        $m[3] += 4;
+        $m[3] -= 4;
+        alloc $m 3000;
+        $m[2999] = "x";
+        print $m[1024], " ", $m[2048], " ", $m[3], " ", $m[2999], endl;
+} end
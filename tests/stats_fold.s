@@ -0,0 +1,12 @@
+program "stats_fold";
+begin {
+        $k = 2 * 1024;
+        $r = ?sqrt(16.0) + ?pow(2.0, 3);
+        $n = int("42") + 1;
+        if 3 > 2
+                print "folded ", $k, " ", $r, " ", $n, endl;
+        print "a", "b", "c", endl;
+        print "before", endl;
+        print 1 / 0, endl;
+        print "after", endl;
+} end
@@ -0,0 +1,14 @@
+program "stats_fuse";
+begin {
+        $i = 0;
+        $n = 0;
+        $s = "s";
+        alloc $a 8;
+        while $i < 8 {
+                $a[$i] = $i * 2;
+                $n = $n + $a[$i];
+                $s = $s + "x";
+                inc $i;
+        }
+        print $n, " ", $s, endl;
+} end
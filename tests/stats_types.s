@@ -0,0 +1,13 @@
+program "stats_types";
+begin {
+        $i = 0;
+        $sum = 0;
+        $odd = 0;
+        while $i < 100 {
+                $sum = $sum + $i * $i;
+                if $i % 2 == 1
+                        $odd = $odd + 1;
+                $i = $i + 1;
+        }
+        print $sum, " ", $odd, " ", $sum / $odd - $i, endl;
+} end
@@ -0,0 +1,6 @@
+program "type_mismatch";
+begin {
+        print "never printed", endl;
+        $s = "text";
+        $n = $s - 1;
+} end
@@ -0,0 +1,453 @@
+#include <cstdio>
+#include <cstring>
+#include "typechecker.hpp"
+#include "error.hpp"
+
+TypeChecker::TypeChecker()
+{
+        prog = 0;
+        slots = 0;
+        size = 0;
+        entry = 0;
+        cur = 0;
+        pending = 0;
+        sp = 0;
+        final = false;
+        proven = 0;
+}
+
+TypeChecker::~TypeChecker()
+{
+        if (entry) {
+                for (long i = 0; i <= size; i++)
+                        delete[] entry[i];
+                delete[] entry;
+        }
+        delete[] cur;
+}
+
+void TypeChecker::Run(RPNProgram *P, long vars)
+{
+        prog = P;
+        slots = vars;
+        size = prog->Size();
+        entry = new TypeSet*[size + 1];
+        for (long i = 0; i <= size; i++)
+                entry[i] = 0;
+        cur = new TypeSet[slots + 1];
+        FindScalars();
+        FindLeaders();
+        entry[0] = new TypeSet[slots + 1];
+        memset(entry[0], 0, slots + 1);
+        work[pending++] = 0;
+        while (pending)
+                Walk(work[--pending]);
+        final = true;
+        for (long i = 0; i < size; i++) {
+                if (leader[i] && entry[i])
+                        Walk(i);
+        }
+}
+
+void TypeChecker::Report() const
+{
+        fprintf(stderr, "proven int sites     %ld\n", proven);
+}
+
+void TypeChecker::FindScalars()
+{
+        for (long i = 0; i < slots; i++)
+                scalar[i] = true;
+        for (long i = 0; i < size; i++) {
+                const RPNInstr& cmd = (*prog)[i];
+                if (cmd.op == rpn_push_addr)
+                        scalar[cmd.arg.integer] = false;
+                else if (cmd.op == rpn_addr_index || cmd.op == rpn_load_index)
+                        scalar[cmd.slot] = false;
+        }
+}
+
+void TypeChecker::FindLeaders()
+{
+        for (long i = 0; i <= size; i++)
+                leader[i] = false;
+        leader[0] = true;
+        for (long i = 0; i < size; i++) {
+                if (!RPNProgram::IsJump((*prog)[i].op))
+                        continue;
+                leader[(*prog)[i].arg.integer] = true;
+                leader[i + 1] = true;
+        }
+}
+
+void TypeChecker::Walk(long start)
+{
+        memcpy(cur, entry[start], slots + 1);
+        sp = 0;
+        for (long i = start; i < size; i++) {
+                if (i != start && leader[i]) {
+                        Merge(i);
+                        return;
+                }
+                Step(i);
+                const RPNInstr& cmd = (*prog)[i];
+                if (!RPNProgram::IsJump(cmd.op))
+                        continue;
+                Merge(cmd.arg.integer);
+                if (cmd.op == rpn_jump)
+                        return;
+        }
+}
+
+void TypeChecker::Merge(long idx)
+{
+        if (final || idx == size)
+                return;
+        bool changed = false;
+        if (!entry[idx]) {
+                entry[idx] = new TypeSet[slots + 1];
+                memcpy(entry[idx], cur, slots + 1);
+                changed = true;
+        } else {
+                for (long i = 0; i < slots; i++) {
+                        if ((entry[idx][i] | cur[i]) != entry[idx][i]) {
+                                entry[idx][i] |= cur[i];
+                                changed = true;
+                        }
+                }
+        }
+        if (changed)
+                work[pending++] = idx;
+}
+
+void TypeChecker::Step(long idx)
+{
+        RPNInstr& cmd = (*prog)[idx];
+        long slot;
+        TypeSet t;
+        switch (cmd.op) {
+        case rpn_nop:
+        case rpn_jump:
+                break;
+        case rpn_push_bool:
+                Push(type_bool);
+                break;
+        case rpn_push_int:
+                Push(type_int);
+                break;
+        case rpn_push_double:
+                Push(type_double);
+                break;
+        case rpn_push_string:
+                Push(type_string);
+                break;
+        case rpn_push_addr:
+                PushAddr(cmd.arg.integer);
+                break;
+        case rpn_jump_false:
+                Require(idx, Pop(), type_bool);
+                break;
+        case rpn_alloc:
+                Require(idx, Pop(), type_int);
+                Store(PopAddr(), type_int);
+                break;
+        case rpn_free:
+                PopAddr();
+                break;
+        case rpn_copy:
+                slot = PopAddr();
+                Store(PopAddr(), Load(slot));
+                break;
+        case rpn_map:
+                Require(idx, Pop(), type_int);
+                Require(idx, Pop(), type_string);
+                Store(PopAddr(), TypeSet(1 << cmd.arg.integer));
+                break;
+        case rpn_var:
+                Push(Load(PopAddr()));
+                break;
+        case rpn_inc:
+        case rpn_dec:
+                slot = PopAddr();
+                Require(idx, Load(slot), type_int);
+                Store(slot, type_int);
+                break;
+        case rpn_assign:
+        case rpn_append:
+                t = Pop();
+                Store(PopAddr(), t);
+                break;
+        case rpn_index:
+                Require(idx, Pop(), type_int);
+                PushAddr(PopAddr());
+                break;
+        case rpn_plus:
+        case rpn_plus_int:
+        case rpn_plus_ii:
+                Push(Same(idx, type_number | type_string, rpn_plus_ii));
+                break;
+        case rpn_minus:
+        case rpn_minus_int:
+        case rpn_minus_ii:
+                Push(Same(idx, type_number, rpn_minus_ii));
+                break;
+        case rpn_mul:
+        case rpn_mul_int:
+        case rpn_mul_ii:
+                Push(Same(idx, type_number, rpn_mul_ii));
+                break;
+        case rpn_div:
+        case rpn_div_int:
+        case rpn_div_ii:
+                Push(Same(idx, type_number, rpn_div_ii));
+                break;
+        case rpn_mod:
+        case rpn_mod_int:
+        case rpn_mod_ii:
+                Push(Same(idx, type_int, rpn_mod_ii));
+                break;
+        case rpn_uminus:
+        case rpn_abs:
+                t = Pop();
+                Require(idx, t, type_number);
+                Push(t & type_number ? t & type_number : type_number);
+                break;
+        case rpn_eq:
+        case rpn_xor:
+        case rpn_or:
+        case rpn_and:
+                Require(idx, Pop(), type_bool);
+                Require(idx, Pop(), type_bool);
+                Push(type_bool);
+                break;
+        case rpn_not:
+                Require(idx, Pop(), type_bool);
+                Push(type_bool);
+                break;
+        case rpn_equ:
+        case rpn_equ_int:
+        case rpn_equ_ii:
+                Same(idx, type_any, rpn_equ_ii);
+                Push(type_bool);
+                break;
+        case rpn_neq:
+        case rpn_neq_int:
+        case rpn_neq_ii:
+                Same(idx, type_any, rpn_neq_ii);
+                Push(type_bool);
+                break;
+        case rpn_gtr:
+        case rpn_gtr_int:
+        case rpn_gtr_ii:
+                Same(idx, type_any, rpn_gtr_ii);
+                Push(type_bool);
+                break;
+        case rpn_lss:
+        case rpn_lss_int:
+        case rpn_lss_ii:
+                Same(idx, type_any, rpn_lss_ii);
+                Push(type_bool);
+                break;
+        case rpn_geq:
+        case rpn_geq_int:
+        case rpn_geq_ii:
+                Same(idx, type_any, rpn_geq_ii);
+                Push(type_bool);
+                break;
+        case rpn_leq:
+        case rpn_leq_int:
+        case rpn_leq_ii:
+                Same(idx, type_any, rpn_leq_ii);
+                Push(type_bool);
+                break;
+        case rpn_print:
+                for (long i = 0; i < cmd.arg.integer; i++)
+                        Require(idx, Pop(), type_string);
+                break;
+        case rpn_scan:
+                Store(PopAddr(), type_string);
+                break;
+        case rpn_cast_bool:
+                Pop();
+                Push(type_bool);
+                break;
+        case rpn_cast_int:
+                Pop();
+                Push(type_int);
+                break;
+        case rpn_cast_double:
+                Pop();
+                Push(type_double);
+                break;
+        case rpn_cast_string:
+                Pop();
+                Push(type_string);
+                break;
+        case rpn_rand:
+                Require(idx, Pop(), type_int);
+                Push(type_int);
+                break;
+        case rpn_pow:
+                Require(idx, Pop(), type_int);
+                Require(idx, Pop(), type_double);
+                Push(type_double);
+                break;
+        case rpn_sqrt:
+        case rpn_sin:
+        case rpn_cos:
+        case rpn_tan:
+        case rpn_asin:
+        case rpn_acos:
+        case rpn_atan:
+        case rpn_exp:
+        case rpn_log:
+        case rpn_ceil:
+        case rpn_floor:
+        case rpn_trunc:
+        case rpn_round:
+                Require(idx, Pop(), type_double);
+                Push(type_double);
+                break;
+        case rpn_atan2:
+        case rpn_max:
+        case rpn_min:
+                Require(idx, Pop(), type_double);
+                Require(idx, Pop(), type_double);
+                Push(type_double);
+                break;
+        case rpn_load:
+                Push(Load(cmd.slot));
+                break;
+        case rpn_load_index:
+                Require(idx, Pop(), type_int);
+                Push(Load(cmd.slot));
+                break;
+        case rpn_addr_index:
+                Require(idx, Pop(), type_int);
+                PushAddr(cmd.slot);
+                break;
+        case rpn_store:
+                Store(cmd.slot, Pop());
+                break;
+        case rpn_assign_int:
+                Store(cmd.slot, type_int);
+                break;
+        case rpn_inc_var:
+        case rpn_dec_var:
+                Require(idx, Load(cmd.slot), type_int);
+                Store(cmd.slot, type_int);
+                break;
+        case rpn_load_plus_int:
+        case rpn_load_minus_int:
+        case rpn_load_mul_int:
+        case rpn_load_div_int:
+        case rpn_load_mod_int:
+                Require(idx, Load(cmd.slot), type_int);
+                Push(type_int);
+                break;
+        case rpn_equ_jump:
+        case rpn_equ_jump_int:
+        case rpn_equ_jump_ii:
+                Same(idx, type_any, rpn_equ_jump_ii);
+                break;
+        case rpn_neq_jump:
+        case rpn_neq_jump_int:
+        case rpn_neq_jump_ii:
+                Same(idx, type_any, rpn_neq_jump_ii);
+                break;
+        case rpn_gtr_jump:
+        case rpn_gtr_jump_int:
+        case rpn_gtr_jump_ii:
+                Same(idx, type_any, rpn_gtr_jump_ii);
+                break;
+        case rpn_lss_jump:
+        case rpn_lss_jump_int:
+        case rpn_lss_jump_ii:
+                Same(idx, type_any, rpn_lss_jump_ii);
+                break;
+        case rpn_geq_jump:
+        case rpn_geq_jump_int:
+        case rpn_geq_jump_ii:
+                Same(idx, type_any, rpn_geq_jump_ii);
+                break;
+        case rpn_leq_jump:
+        case rpn_leq_jump_int:
+        case rpn_leq_jump_ii:
+                Same(idx, type_any, rpn_leq_jump_ii);
+                break;
+        case rpn_plus_store:
+                Update(idx, cmd.slot, type_number | type_string);
+                break;
+        case rpn_minus_store:
+        case rpn_mul_store:
+        case rpn_div_store:
+                Update(idx, cmd.slot, type_number);
+                break;
+        case rpn_mod_store:
+                Update(idx, cmd.slot, type_int);
+                break;
+        case rpn_plus_assign:
+                t = Pop();
+                slot = PopAddr();
+                Push(t);
+                Update(idx, slot, type_number | type_string);
+                break;
+        case rpn_minus_assign:
+        case rpn_mul_assign:
+        case rpn_div_assign:
+                t = Pop();
+                slot = PopAddr();
+                Push(t);
+                Update(idx, slot, type_number);
+                break;
+        case rpn_mod_assign:
+                t = Pop();
+                slot = PopAddr();
+                Push(t);
+                Update(idx, slot, type_int);
+                break;
+        }
+}
+
+void TypeChecker::Store(long slot, TypeSet t)
+{
+        if (scalar[slot])
+                cur[slot] = t;
+        else
+                cur[slot] |= t;
+}
+
+void TypeChecker::Update(long idx, long slot, TypeSet allowed)
+{
+        TypeSet t = Pop();
+        Push(Load(slot));
+        Push(t);
+        Store(slot, Same(idx, allowed, (*prog)[idx].op));
+}
+
+void TypeChecker::Require(long idx, TypeSet t, TypeSet allowed)
+{
+        if (final && !(t & allowed))
+                throw SyntaxError("data type mismatch", (*prog)[idx].line);
+}
+
+TypeChecker::TypeSet TypeChecker::Same(long idx, TypeSet allowed,
+                                       RPNOpCode op)
+{
+        TypeSet t2 = Pop();
+        TypeSet t1 = Pop();
+        TypeSet res = t1 & t2 & allowed;
+        Require(idx, res, allowed);
+        if (t1 == type_int && t2 == type_int)
+                Prove(idx, op);
+        return res ? res : allowed;
+}
+
+void TypeChecker::Prove(long idx, RPNOpCode op)
+{
+        if (!final || (*prog)[idx].op == op)
+                return;
+        (*prog)[idx].op = op;
+        proven++;
+}
+
@@ -0,0 +1,58 @@
+#ifndef TYPECHECKER_HPP_SENTRY
+#define TYPECHECKER_HPP_SENTRY
+
+#include "engine.hpp"
+#include "buffer.hpp"
+
+class TypeChecker {
+        typedef unsigned char TypeSet;
+        enum {
+                type_bool = 1 << bool_type,
+                type_int = 1 << int_type,
+                type_double = 1 << double_type,
+                type_string = 1 << string_type,
+                type_number = type_int | type_double,
+                type_any = type_number | type_bool | type_string
+        };
+        RPNProgram *prog;
+        long slots;
+        long size;
+        TypeSet **entry;
+        TypeSet *cur;
+        Buffer<bool> scalar;
+        Buffer<bool> leader;
+        Buffer<long> work;
+        long pending;
+        Buffer<TypeSet> types;
+        Buffer<long> addrs;
+        long sp;
+        bool final;
+        long proven;
+public:
+        TypeChecker();
+        ~TypeChecker();
+        void Run(RPNProgram *P, long vars);
+        void Report() const;
+private:
+        TypeChecker(const TypeChecker&);
+        void operator=(const TypeChecker&);
+        void FindScalars();
+        void FindLeaders();
+        void Walk(long start);
+        void Merge(long idx);
+        void Step(long idx);
+        void Push(TypeSet t) { types[sp++] = t; }
+        void PushAddr(long slot) { addrs[sp] = slot; types[sp++] = 0; }
+        TypeSet Pop() { return types[--sp]; }
+        long PopAddr() { return addrs[--sp]; }
+        TypeSet Load(long slot) const
+                { return cur[slot] ? cur[slot] : TypeSet(type_any); }
+        void Store(long slot, TypeSet t);
+        void Update(long idx, long slot, TypeSet allowed);
+        void Require(long idx, TypeSet t, TypeSet allowed);
+        TypeSet Same(long idx, TypeSet allowed, RPNOpCode op);
+        void Prove(long idx, RPNOpCode op);
+};
+
+#endif
+
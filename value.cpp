@@ -0,0 +1,114 @@
+#include <cstring>
+#include "value.hpp"
+#include "arena.hpp"
+
+StringData *StringData::Alloc(long len, long capacity, Arena *arena)
+{
+        size_t size = sizeof(StringData) + capacity;
+        char *mem = arena ? (char *)arena->Alloc(size) : new char[size];
+        StringData *res = (StringData *)mem;
+        res->refs = 1;
+        res->length = len;
+        res->capacity = capacity;
+        res->text[len] = 0;
+        return res;
+}
+
+StringData *StringData::Create(const char *str, long len)
+{
+        StringData *res = Alloc(len, len);
+        memcpy(res->text, str, len);
+        return res;
+}
+
+Value& Value::operator=(const Value& val)
+{
+        if (this == &val)
+                return *this;
+        Release();
+        Copy(val);
+        return *this;
+}
+
+void Value::Set(const char *val, long len)
+{
+        if (len <= inplace_max) {
+                char buf[inplace_max];
+                memcpy(buf, val, len);
+                memcpy(Reserve(len), buf, len);
+                return;
+        }
+        StringData *res = StringData::Create(val, len);
+        Clear(string_type);
+        large.value.string = res;
+}
+
+void Value::Set(StringData *val)
+{
+        if (val->length <= inplace_max) {
+                Set(val->text, val->length);
+                return;
+        }
+        val->Ref();
+        Clear(string_type);
+        large.value.string = val;
+}
+
+void Value::Append(const Value& val, Arena *arena)
+{
+        long len1 = Length(), len2 = val.Length();
+        if (len1 + len2 <= inplace_max) {
+                memmove(small.text + len1, val.String(), len2 + 1);
+                small.head.inplace = len1 + len2 + 1;
+                return;
+        }
+        StringData *str = head.inplace ? 0 : large.value.string;
+        bool unique = str && (large.temporary || str->refs == 1);
+        if (unique && len1 + len2 <= str->capacity) {
+                memcpy(str->text + len1, val.String(), len2);
+                str->length = len1 + len2;
+                str->text[str->length] = 0;
+                return;
+        }
+        long len = len1 + len2;
+        str = StringData::Alloc(len, str ? 2 * len : len, arena);
+        memcpy(str->text, String(), len1);
+        memcpy(str->text + len1, val.String(), len2);
+        Clear(string_type);
+        large.value.string = str;
+        large.temporary = arena != 0;
+}
+
+void Value::Copy(const Value& val)
+{
+        if (val.head.type != string_type) {
+                large = val.large;
+        } else if (val.head.inplace) {
+                small = val.small;
+        } else if (val.large.temporary) {
+                Init(int_type);
+                Set(val.String(), val.Length());
+        } else {
+                large = val.large;
+                large.value.string->Ref();
+        }
+}
+
+char *Value::Reserve(long len)
+{
+        Release();
+        char *text;
+        if (len <= inplace_max) {
+                small.head.type = string_type;
+                small.head.inplace = len + 1;
+                text = small.text;
+        } else {
+                large.head.type = string_type;
+                large.head.inplace = 0;
+                large.value.string = StringData::Alloc(len, len);
+                text = large.value.string->text;
+        }
+        text[len] = 0;
+        return text;
+}
+
@@ -0,0 +1,128 @@
+#ifndef VALUE_HPP_SENTRY
+#define VALUE_HPP_SENTRY
+
+#include <cstring>
+#include "common.hpp"
+#include "error.hpp"
+
+enum DataType {
+        bool_type,
+        int_type,
+        double_type,
+        string_type
+};
+
+class Arena;
+
+struct StringData {
+        long refs;
+        long length;
+        long capacity;
+        char text[1];
+        static StringData *Alloc(long len, long capacity, Arena *arena = 0);
+        static StringData *Create(const char *str, long len);
+        void Ref() { refs++; }
+        void Unref() { if (--refs == 0) delete[] (char *)this; }
+};
+
+class Value {
+        enum { inplace_max = 13 };
+        struct Header {
+                unsigned char type;
+                unsigned char inplace;
+        };
+        struct Small {
+                Header head;
+                char text[inplace_max + 1];
+        };
+        struct Large {
+                Header head;
+                bool temporary;
+                int slot;
+                union {
+                        bool boolean;
+                        long integer;
+                        double real;
+                        StringData *string;
+                } value;
+        };
+        union {
+                Header head;
+                Small small;
+                Large large;
+        };
+public:
+        Value() { Init(int_type); large.value.integer = 0; }
+        Value(const char *val) { Init(int_type); Set(val); }
+        Value(const Value& val) { Init(int_type); Copy(val); }
+        ~Value() { Release(); }
+        Value& operator=(const Value& val);
+        void Set(bool val) { Clear(bool_type); large.value.boolean = val; }
+        void Set(long val) { Clear(int_type); large.value.integer = val; }
+        void Set(double val) { Clear(double_type); large.value.real = val; }
+        void Set(const char *val) { Set(val, strlen(val)); }
+        void Set(const char *val, long len);
+        void Set(StringData *val);
+        void Append(const Value& val, Arena *arena = 0);
+        void SetAddr(long num, long idx) {
+                Clear(int_type);
+                large.slot = num;
+                large.value.integer = idx;
+        }
+        DataType Type() const { return DataType(head.type); }
+        bool GetBool() const {
+                if (head.type != bool_type)
+                        throw RuntimeError("RPNValue", "data type mismatch");
+                return large.value.boolean;
+        }
+        long GetInt() const {
+                if (head.type != int_type)
+                        throw RuntimeError("RPNValue", "data type mismatch");
+                return large.value.integer;
+        }
+        double GetDouble() const {
+                if (head.type != double_type)
+                        throw RuntimeError("RPNValue", "data type mismatch");
+                return large.value.real;
+        }
+        const char *GetString() const {
+                if (head.type != string_type)
+                        throw RuntimeError("RPNValue", "data type mismatch");
+                return String();
+        }
+        bool Bool() const { return large.value.boolean; }
+        long Int() const { return large.value.integer; }
+        double Double() const { return large.value.real; }
+        const char *String() const
+                { return head.inplace ? small.text : large.value.string->text; }
+        long Length() const {
+                return head.inplace ? head.inplace - 1 :
+                        large.value.string->length;
+        }
+        void SetInt(long val) { large.value.integer = val; }
+        void Swap(Value& val) {
+                Small tmp = small;
+                small = val.small;
+                val.small = tmp;
+        }
+        long Slot() const { return large.slot; }
+        long Index() const { return large.value.integer; }
+private:
+        void Init(DataType t) {
+                large.head.type = t;
+                large.head.inplace = 0;
+                large.temporary = false;
+                large.slot = 0;
+        }
+        void Clear(DataType t) { Release(); Init(t); }
+        void Release() {
+                if (head.type == string_type && !head.inplace &&
+                    !large.temporary)
+                        large.value.string->Unref();
+        }
+        void Copy(const Value& val);
+        char *Reserve(long len);
+};
+
+#endif
+
@@ -1,28 +1,70 @@
 #include "vartable.hpp"
 
-void VarTable::Alloc(const char *name, long size)
+VarTable::VarTable()
 {
-        if (table.Find(name))
-                table[name].Allocate(size);
-        else
-                table.Add(Array(size), name);
+        size = 0;
+        allocated = 8;
+        vars = new Array[allocated];
+        names = new char*[allocated];
 }
 
-void VarTable::Free(const char *name)
+VarTable::~VarTable()
 {
-        table[name].Allocate(1);
-        table.Remove(name);
+        for (long i = 0; i < size; i++)
+                delete[] names[i];
+        delete[] names;
+        delete[] vars;
 }
 
-void VarTable::SetValue(const char *name, long index, RPNValue *val)
+long VarTable::Resolve(const char *name)
 {
-        if (!table.Find(name))
-                table.Add(Array(1), name);
-        table[name][index].Set(val);
+        bool added;
+        long& slot = symbols.FindOrAdd(size, name, added);
+        if (!added)
+                return slot;
+        if (size == allocated) {
+                allocated <<= 1;
+                Array *tmp = new Array[allocated];
+                char **tmp_names = new char*[allocated];
+                for (long i = 0; i < size; i++) {
+                        tmp[i].Swap(vars[i]);
+                        tmp_names[i] = names[i];
+                }
+                delete[] vars;
+                delete[] names;
+                vars = tmp;
+                names = tmp_names;
+        }
+        names[size] = dupstr(name);
+        return size++;
 }
 
-RPNValue *VarTable::GetValue(const char *name, long index) const
+void VarTable::Alloc(long slot, long size)
 {
-        return table[name][index].Get();
+        vars[slot].Allocate(size);
+}
+
+void VarTable::Free(long slot)
+{
+        Defined(slot).Clear();
+}
+
+void VarTable::SetValue(long slot, long index, const Value& val)
+{
+        if (vars[slot].Empty())
+                vars[slot].Allocate(1);
+        vars[slot].Set(index, val);
+}
+
+void VarTable::GetValue(long slot, long index, Value& val) const
+{
+        Defined(slot).Get(index, val);
+}
+
+Array& VarTable::Defined(long slot) const
+{
+        if (vars[slot].Empty())
+                throw RuntimeError("not found in table", names[slot]);
+        return vars[slot];
 }
 
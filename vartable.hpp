@@ -5,13 +5,29 @@
 #include "array.hpp"
 
 class VarTable {
-        HashTable<Array> table;
+        HashTable<long> symbols;
+        Array *vars;
+        char **names;
+        long size;
+        long allocated;
 public:
-        VarTable() {}
-        void Alloc(const char *name, long size);
-        void Free(const char *name);
-        void SetValue(const char *name, long index, RPNValue *val);
-        RPNValue *GetValue(const char *name, long index) const;
+        VarTable();
+        ~VarTable();
+        long Resolve(const char *name);
+        long Size() const { return size; }
+        void Alloc(long slot, long size);
+        void Free(long slot);
+        void Map(long slot, const char *name, DataType type, long size)
+                { vars[slot].Map(name, type, size); }
+        void Append(long slot, const Value& val) { vars[slot].Append(val); }
+        void Copy(long dst, long src) { vars[dst].Share(Defined(src)); }
+        void SetValue(long slot, long index, const Value& val);
+        void GetValue(long slot, long index, Value& val) const;
+        Array& Lookup(long slot) const { return Defined(slot); }
+private:
+        VarTable(const VarTable&);
+        void operator=(const VarTable&);
+        Array& Defined(long slot) const;
 };
 
 #endif